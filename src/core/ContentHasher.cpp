@@ -0,0 +1,110 @@
+/**
+ * @file ContentHasher.cpp
+ * @brief Cached content hashes implementation
+ */
+
+#include "ContentHasher.h"
+#include "FileUtils.h"
+#include "Logger.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+ContentHasher::ContentHasher()
+{
+    load();
+}
+
+ContentHasher& ContentHasher::instance()
+{
+    static ContentHasher instance;
+    return instance;
+}
+
+QString ContentHasher::hash(const QString& path)
+{
+    QFileInfo info(path);
+    if (!info.exists()) return QString();
+    
+    qint64 size = info.size();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cache.constFind(path);
+        if (it != m_cache.constEnd() && it->size == size && it->modified == modified) {
+            return it->digest;
+        }
+    }
+    
+    // Hash outside the lock so several files are read in parallel
+    QString digest = FileUtils::fileChecksum(path);
+    if (digest.isEmpty()) return digest;
+    
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(path, {size, modified, digest});
+    m_dirty = true;
+    return digest;
+}
+
+void ContentHasher::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) return;
+    
+    QString path = cachePath();
+    FileUtils::ensureDirectoryExists(QFileInfo(path).absolutePath());
+    
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        Logger::warning("Failed to write content hash cache: " + path);
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << CacheVersion << static_cast<qint32>(m_cache.size());
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        stream << it.key() << it->size << it->modified << it->digest;
+    }
+    
+    if (file.commit()) {
+        m_dirty = false;
+    }
+}
+
+void ContentHasher::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    qint32 version = 0;
+    qint32 count = 0;
+    stream >> version >> count;
+    
+    // Digests from another algorithm would never match new ones; rehash instead
+    if (version != CacheVersion) return;
+    
+    m_cache.reserve(count);
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        CacheEntry entry;
+        stream >> path >> entry.size >> entry.modified >> entry.digest;
+        m_cache.insert(path, entry);
+    }
+    
+    // A truncated cache is only a performance loss; start over
+    if (stream.status() != QDataStream::Ok) {
+        m_cache.clear();
+    }
+}
+
+QString ContentHasher::cachePath() const
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QString("%1/content-hashes.dat").arg(dataDir);
+}
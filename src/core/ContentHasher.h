@@ -0,0 +1,48 @@
+/**
+ * @file ContentHasher.h
+ * @brief Cached content hashes for duplicate input detection
+ */
+
+#ifndef CONTENTHASHER_H
+#define CONTENTHASHER_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+class ContentHasher
+{
+public:
+    static ContentHasher& instance();
+
+    // Thread-safe; reuses the cached digest while path, size and mtime match
+    QString hash(const QString& path);
+    
+    // Persists new digests so re-adding a library does not rehash it
+    void save();
+
+private:
+    ContentHasher();
+    ~ContentHasher() = default;
+    ContentHasher(const ContentHasher&) = delete;
+    ContentHasher& operator=(const ContentHasher&) = delete;
+
+    struct CacheEntry {
+        qint64 size = 0;
+        qint64 modified = 0;
+        QString digest;
+    };
+
+    void load();
+    QString cachePath() const;
+
+    // Bumped whenever FileUtils::fileChecksum changes algorithm
+    static constexpr qint32 CacheVersion = 2;
+
+private:
+    QHash<QString, CacheEntry> m_cache;
+    QMutex m_mutex;
+    bool m_dirty = false;
+};
+
+#endif // CONTENTHASHER_H
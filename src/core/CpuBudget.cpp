@@ -0,0 +1,59 @@
+/**
+ * @file CpuBudget.cpp
+ * @brief CPU thread budget implementation
+ */
+
+#include "CpuBudget.h"
+
+#include <QtGlobal>
+
+CpuBudget::CpuBudget(int totalThreads)
+{
+    setTotalThreads(totalThreads);
+}
+
+void CpuBudget::setTotalThreads(int threads)
+{
+    m_totalThreads = qMax(1, threads);
+}
+
+int CpuBudget::acquire(JobType type, int activeWeight, int reserved)
+{
+    // Never grant more than is currently free; the queue holds a job back
+    // rather than start it with nothing
+    int available = freeThreads() - qMax(0, reserved);
+    if (available <= 0) return 0;
+    
+    int granted = qMin(fairShare(type, activeWeight), available);
+    m_allocatedThreads += granted;
+    return granted;
+}
+
+int CpuBudget::grow(JobType type, int current, int activeWeight)
+{
+    int extra = qBound(0, fairShare(type, activeWeight) - current, freeThreads());
+    m_allocatedThreads += extra;
+    return extra;
+}
+
+void CpuBudget::release(int threads)
+{
+    m_allocatedThreads = qMax(0, m_allocatedThreads - threads);
+}
+
+void CpuBudget::reset()
+{
+    m_allocatedThreads = 0;
+}
+
+int CpuBudget::weightFor(JobType type)
+{
+    // An encode scales across many cores; a still image barely uses more than one
+    return type == JobType::Video ? 4 : 1;
+}
+
+int CpuBudget::fairShare(JobType type, int activeWeight) const
+{
+    int weight = weightFor(type);
+    return qMax(1, m_totalThreads * weight / qMax(weight, activeWeight));
+}
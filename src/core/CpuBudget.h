@@ -0,0 +1,42 @@
+/**
+ * @file CpuBudget.h
+ * @brief CPU thread budget shared by concurrently running jobs
+ */
+
+#ifndef CPUBUDGET_H
+#define CPUBUDGET_H
+
+#include "Job.h"
+
+class CpuBudget
+{
+public:
+    explicit CpuBudget(int totalThreads = 1);
+
+    void setTotalThreads(int threads);
+    int totalThreads() const { return m_totalThreads; }
+    int allocatedThreads() const { return m_allocatedThreads; }
+    int freeThreads() const { return qMax(0, m_totalThreads - m_allocatedThreads); }
+
+    // Weighted share for a job of the given type, given the combined weight
+    // of every job that will be running alongside it (itself included).
+    // Never more than is free once @p reserved threads are kept back for jobs
+    // starting at the same time; 0 when nothing is left
+    int acquire(JobType type, int activeWeight, int reserved = 0);
+    
+    // Extra threads that bring a running job's grant of @p current towards its
+    // share; only threads nobody else holds are handed out
+    int grow(JobType type, int current, int activeWeight);
+    void release(int threads);
+    void reset();
+
+    static int weightFor(JobType type);
+
+private:
+    int fairShare(JobType type, int activeWeight) const;
+
+    int m_totalThreads = 1;
+    int m_allocatedThreads = 0;
+};
+
+#endif // CPUBUDGET_H
@@ -0,0 +1,53 @@
+/**
+ * @file EncodeProfile.cpp
+ * @brief Encode settings snapshot implementation
+ */
+
+#include "EncodeProfile.h"
+#include "Settings.h"
+
+std::shared_ptr<const EncodeProfile> EncodeProfile::fromSettings(const Settings& settings)
+{
+    auto profile = std::make_shared<EncodeProfile>();
+    
+    profile->outputFolder = settings.outputFolder();
+    profile->overwriteOriginal = settings.overwriteOriginal();
+    
+    profile->imageOutputFormat = settings.imageOutputFormat();
+    profile->imageCompressionMode = settings.imageCompressionMode();
+    profile->imageQuality = settings.imageQuality();
+    profile->preserveMetadata = settings.preserveMetadata();
+    profile->jpegXlEffort = settings.jpegXlEffort();
+    profile->avifSpeed = settings.avifSpeed();
+    profile->webpMethod = settings.webpMethod();
+    
+    profile->videoOutputFormat = settings.videoOutputFormat();
+    profile->videoCodec = settings.videoCodec();
+    profile->videoCompressionMode = settings.videoCompressionMode();
+    profile->videoCrf = settings.videoCrf();
+    profile->videoQualityMetric = settings.videoQualityMetric();
+    profile->videoTargetQuality = settings.videoTargetQuality();
+    profile->videoPreset = settings.videoPreset();
+    profile->chunkedEncode = settings.chunkedEncode();
+    profile->videoChunkCount = settings.videoChunkCount();
+    profile->smartStreamCopy = settings.smartStreamCopy();
+    profile->contentTuning = settings.contentTuning();
+    profile->av1Preset = settings.av1Preset();
+    profile->av1TileColumns = settings.av1TileColumns();
+    profile->av1TileRows = settings.av1TileRows();
+    profile->av1Lookahead = settings.av1Lookahead();
+    profile->av1MaxThreads = settings.av1MaxThreads();
+    
+    profile->preserveAudio = settings.preserveAudio();
+    profile->audioCodec = settings.audioCodec();
+    profile->audioBitrate = settings.audioBitrate();
+    
+    profile->useGpu = settings.useGpu();
+    profile->useNvenc = settings.useNvenc();
+    profile->useNvdec = settings.useNvdec();
+    profile->ffmpegPath = settings.ffmpegPath();
+    profile->vipsPath = settings.vipsPath();
+    profile->inProcessVideo = settings.inProcessVideo();
+    
+    return profile;
+}
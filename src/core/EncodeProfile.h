@@ -0,0 +1,68 @@
+/**
+ * @file EncodeProfile.h
+ * @brief Immutable snapshot of the encode settings for one batch
+ */
+
+#ifndef ENCODEPROFILE_H
+#define ENCODEPROFILE_H
+
+#include <QString>
+#include <memory>
+
+class Settings;
+
+// Captured on the GUI thread when a batch is queued; workers read it
+// instead of Settings, and later edits only affect the next batch
+struct EncodeProfile {
+    // Output
+    QString outputFolder;
+    bool overwriteOriginal = false;
+    
+    // Image
+    QString imageOutputFormat;
+    QString imageCompressionMode;
+    int imageQuality = 95;
+    bool preserveMetadata = false;
+    int jpegXlEffort = 7;
+    int avifSpeed = 6;
+    int webpMethod = 4;
+    
+    // Video
+    QString videoOutputFormat;
+    QString videoCodec;
+    QString videoCompressionMode;
+    int videoCrf = 18;
+    QString videoQualityMetric;
+    double videoTargetQuality = 93.0;
+    QString videoPreset;
+    bool chunkedEncode = false;
+    int videoChunkCount = 0;
+    bool smartStreamCopy = true;
+    bool contentTuning = true;
+    int av1Preset = -1;         // -1 = from compression mode
+    int av1TileColumns = -1;    // -1 = from resolution
+    int av1TileRows = -1;
+    int av1Lookahead = -1;
+    int av1MaxThreads = 0;
+    
+    // Audio
+    bool preserveAudio = true;
+    QString audioCodec;
+    int audioBitrate = 192;
+    
+    // Hardware and tools
+    bool useGpu = false;
+    bool useNvenc = false;
+    bool useNvdec = false;
+    QString ffmpegPath;
+    QString vipsPath;
+    bool inProcessVideo = true;
+    
+    bool imageLossless() const { return imageCompressionMode == "lossless"; }
+    
+    static std::shared_ptr<const EncodeProfile> fromSettings(const Settings& settings);
+};
+
+using EncodeProfilePtr = std::shared_ptr<const EncodeProfile>;
+
+#endif // ENCODEPROFILE_H
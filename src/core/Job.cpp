@@ -4,62 +4,224 @@
  */
 
 #include "Job.h"
-#include "Settings.h"
+#include "PathPool.h"
 
 #include <QFileInfo>
 #include <QDir>
-#include <QUuid>
+#include <QMutex>
+#include <QWaitCondition>
+#include <chrono>
+#include <iterator>
 
-Job::Job(const QString& inputPath, const Settings& settings)
-    : m_inputPath(inputPath)
+namespace {
+
+// One pair for every job: pausing is rare and waiters re-check their own flag
+QMutex s_pauseMutex;
+QWaitCondition s_pauseCondition;
+
+const char* const kFormatNames[] = {
+    "",
+    "PNG", "JPG", "JPEG", "WEBP", "AVIF", "HEIC", "HEIF", "TIFF", "TIF", "BMP", "JXL", "GIF",
+    "MP4", "MKV", "AVI", "MOV", "WEBM", "WMV", "FLV", "M4V"
+};
+
+// Splits after the last separator so dir + name reproduces the path exactly
+void splitPath(const QString& path, QString& dir, QString& name)
+{
+    int slash = path.lastIndexOf('/');
+#ifdef Q_OS_WIN
+    slash = qMax(slash, path.lastIndexOf('\\'));
+#endif
+    dir = path.left(slash + 1);
+    name = path.mid(slash + 1);
+}
+
+} // namespace
+
+Job::Job(const QString& inputPath, EncodeProfilePtr profile)
+    : m_profile(std::move(profile))
 {
     m_id = generateJobId();
     
+    QString dir;
+    QString name;
+    splitPath(inputPath, dir, name);
+    m_inputDir = PathPool::instance().intern(dir);
+    m_inputName = PathPool::instance().appendName(name);
+    
     QFileInfo info(inputPath);
     m_inputSize = info.size();
-    m_inputFormat = info.suffix().toUpper();
     
-    determineJobType();
-    generateOutputPath(settings);
+    determineJobType(name);
+    generateOutputPath(name);
+}
+
+QString Job::inputPath() const
+{
+    return PathPool::instance().at(m_inputDir) + inputName();
+}
+
+QString Job::inputName() const
+{
+    return PathPool::instance().nameAt(m_inputName);
+}
+
+QString Job::outputPath() const
+{
+    if (m_inPlace) return inputPath();
+    
+    QString baseName = QFileInfo(inputName()).completeBaseName();
+    QString extension = formatName(m_outputFormat).toLower();
+    
+    // Handle special cases
+    if (extension == "jpeg") extension = "jpg";
+    
+    return PathPool::instance().at(m_outputDir) + baseName + "_converted." + extension;
+}
+
+QString Job::inputFormat() const
+{
+    return QFileInfo(inputName()).suffix().toUpper();
+}
+
+QString Job::errorMessage() const
+{
+    return m_cold ? m_cold->errorMessage : QString();
+}
+
+QString Job::outputChecksum() const
+{
+    return m_cold ? m_cold->outputChecksum : QString();
+}
+
+void Job::setOutputChecksum(const QString& checksum)
+{
+    cold().outputChecksum = checksum;
+}
+
+Job::ColdData& Job::cold()
+{
+    if (!m_cold) m_cold = std::make_unique<ColdData>();
+    return *m_cold;
+}
+
+MediaFormat Job::formatFromName(const QString& name)
+{
+    const QString upper = name.toUpper();
+    for (int i = 1; i < int(std::size(kFormatNames)); ++i) {
+        if (upper == QLatin1String(kFormatNames[i])) {
+            return static_cast<MediaFormat>(i);
+        }
+    }
+    return MediaFormat::Unknown;
+}
+
+QString Job::formatName(MediaFormat format)
+{
+    int index = static_cast<int>(format);
+    if (index <= 0 || index >= int(std::size(kFormatNames))) return QString();
+    return QString::fromLatin1(kFormatNames[index]);
 }
 
 void Job::setStatus(JobStatus status)
 {
-    m_status = status;
+    m_status.store(status, std::memory_order_release);
     
-    if (status == JobStatus::Processing && !m_startTime.isValid()) {
-        m_startTime = QDateTime::currentDateTime();
+    if (status == JobStatus::Processing && cold().startMs < 0) {
+        cold().startMs = monotonicMs();
     } else if (status == JobStatus::Completed || 
                status == JobStatus::Failed ||
                status == JobStatus::Cancelled) {
-        m_endTime = QDateTime::currentDateTime();
+        cold().endMs = monotonicMs();
     }
 }
 
 void Job::setProgress(int progress)
 {
-    m_progress = qBound(0, progress, 100);
+    m_progress.store(qBound(0, progress, 100), std::memory_order_relaxed);
+}
+
+bool Job::advanceProgress(int progress, int& previous)
+{
+    int clamped = qBound(0, progress, 100);
+    previous = m_progress.load(std::memory_order_relaxed);
+    do {
+        if (previous == RetiredProgress) return false;
+    } while (!m_progress.compare_exchange_weak(previous, clamped, std::memory_order_relaxed));
+    return true;
+}
+
+int Job::retireProgress()
+{
+    int previous = m_progress.exchange(RetiredProgress, std::memory_order_relaxed);
+    return qMax(0, previous);
 }
 
 void Job::setError(const QString& error)
 {
-    m_errorMessage = error;
-    m_status = JobStatus::Failed;
-    m_endTime = QDateTime::currentDateTime();
+    cold().errorMessage = error;
+    m_status.store(JobStatus::Failed, std::memory_order_release);
+    cold().endMs = monotonicMs();
+}
+
+double Job::encodeFps() const
+{
+    return m_cold ? m_cold->encodeFps.load(std::memory_order_relaxed) : 0.0;
+}
+
+double Job::encodeSpeed() const
+{
+    return m_cold ? m_cold->encodeSpeed.load(std::memory_order_relaxed) : 0.0;
+}
+
+void Job::setEncodeRate(double fps, double speed)
+{
+    ColdData& data = cold();
+    data.encodeFps.store(static_cast<float>(fps), std::memory_order_relaxed);
+    data.encodeSpeed.store(static_cast<float>(speed), std::memory_order_relaxed);
+}
+
+void Job::requestCancel()
+{
+    m_control.fetch_or(CancelRequested, std::memory_order_release);
+    
+    // Release a worker parked in waitWhilePaused()
+    QMutexLocker locker(&s_pauseMutex);
+    s_pauseCondition.wakeAll();
+}
+
+void Job::requestPause()
+{
+    m_control.fetch_or(PauseRequested, std::memory_order_release);
+}
+
+void Job::requestResume()
+{
+    QMutexLocker locker(&s_pauseMutex);
+    m_control.fetch_and(static_cast<quint8>(~PauseRequested), std::memory_order_release);
+    s_pauseCondition.wakeAll();
+}
+
+void Job::waitWhilePaused() const
+{
+    QMutexLocker locker(&s_pauseMutex);
+    while (isPauseRequested() && !isCancelRequested()) {
+        s_pauseCondition.wait(&s_pauseMutex);
+    }
 }
 
 qint64 Job::processingTimeMs() const
 {
-    if (!m_startTime.isValid()) return 0;
+    if (!m_cold || m_cold->startMs < 0) return 0;
     
-    if (m_endTime.isValid()) {
-        return m_startTime.msecsTo(m_endTime);
+    if (m_cold->endMs >= 0) {
+        return m_cold->endMs - m_cold->startMs;
     }
     
-    return m_startTime.msecsTo(QDateTime::currentDateTime());
+    return monotonicMs() - m_cold->startMs;
 }
 
-void Job::determineJobType()
+void Job::determineJobType(const QString& name)
 {
     static const QStringList imageExts = {
         "png", "jpg", "jpeg", "webp", "avif", "heic", "heif", 
@@ -69,7 +231,7 @@ void Job::determineJobType()
         "mp4", "mkv", "avi", "mov", "webm", "wmv", "flv", "m4v"
     };
     
-    QString ext = QFileInfo(m_inputPath).suffix().toLower();
+    QString ext = QFileInfo(name).suffix().toLower();
     
     if (imageExts.contains(ext)) {
         m_type = JobType::Image;
@@ -80,55 +242,41 @@ void Job::determineJobType()
     }
 }
 
-void Job::generateOutputPath(const Settings& settings)
+void Job::generateOutputPath(const QString& name)
 {
-    QFileInfo inputInfo(m_inputPath);
-    QString baseName = inputInfo.completeBaseName();
-    QString outputDir;
+    const EncodeProfile& profile = *m_profile;
+    MediaFormat inputFormat = formatFromName(QFileInfo(name).suffix());
     
-    if (settings.overwriteOriginal()) {
-        outputDir = inputInfo.absolutePath();
-    } else if (!settings.outputFolder().isEmpty()) {
-        outputDir = settings.outputFolder();
+    if (profile.overwriteOriginal || profile.outputFolder.isEmpty()) {
+        m_outputDir = m_inputDir;
     } else {
-        outputDir = inputInfo.absolutePath();
+        QString outputDir = profile.outputFolder;
+        if (!outputDir.endsWith('/')) outputDir += '/';
+        m_outputDir = PathPool::instance().intern(outputDir);
     }
     
     // Determine output format
     if (m_type == JobType::Image) {
-        QString format = settings.imageOutputFormat();
-        if (format == "keep") {
-            m_outputFormat = m_inputFormat;
-        } else {
-            m_outputFormat = format.toUpper();
-        }
+        QString format = profile.imageOutputFormat;
+        m_outputFormat = format == "keep" ? inputFormat : formatFromName(format);
     } else if (m_type == JobType::Video) {
-        QString container = settings.videoOutputFormat();
-        if (container == "keep") {
-            m_outputFormat = m_inputFormat;
-        } else {
-            m_outputFormat = container.toUpper();
-        }
+        QString container = profile.videoOutputFormat;
+        m_outputFormat = container == "keep" ? inputFormat : formatFromName(container);
     }
     
-    // Build output path
-    QString extension = m_outputFormat.toLower();
-    
-    // Handle special cases
-    if (extension == "jpeg") extension = "jpg";
-    
-    m_outputPath = QDir(outputDir).filePath(
-        baseName + "_converted." + extension
-    );
-    
     // If overwriting and same format, use original path
-    if (settings.overwriteOriginal() && 
-        m_outputFormat == m_inputFormat) {
-        m_outputPath = m_inputPath;
-    }
+    m_inPlace = profile.overwriteOriginal && m_type != JobType::Unknown &&
+                m_outputFormat == inputFormat;
+}
+
+JobId Job::generateJobId()
+{
+    static std::atomic<JobId> nextId{1};
+    return nextId.fetch_add(1, std::memory_order_relaxed);
 }
 
-QString Job::generateJobId() const
+qint64 Job::monotonicMs()
 {
-    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
 }
@@ -7,12 +7,15 @@
 #define JOB_H
 
 #include <QString>
-#include <QDateTime>
+#include <atomic>
 #include <memory>
 
-class Settings;
+#include "EncodeProfile.h"
 
-enum class JobStatus {
+// Queue-unique job handle; cheaper to hash and compare than a UUID string
+using JobId = quint32;
+
+enum class JobStatus : quint8 {
     Pending,
     Processing,
     Paused,
@@ -21,67 +24,153 @@ enum class JobStatus {
     Cancelled
 };
 
-enum class JobType {
+enum class JobType : quint8 {
     Image,
     Video,
     Unknown
 };
 
+// Higher priorities are dispatched first; Express jobs get their own reserved slots
+enum class JobPriority : quint8 {
+    Low = 0,
+    Normal,
+    High,
+    Express
+};
+
+// Container/codec formats a job can read or write, stored as one byte per job
+enum class MediaFormat : quint8 {
+    Unknown = 0,
+    Png, Jpg, Jpeg, Webp, Avif, Heic, Heif, Tiff, Tif, Bmp, Jxl, Gif,
+    Mp4, Mkv, Avi, Mov, Webm, Wmv, Flv, M4v
+};
+
 class Job
 {
 public:
-    explicit Job(const QString& inputPath, const Settings& settings);
+    Job(const QString& inputPath, EncodeProfilePtr profile);
     ~Job() = default;
 
     // Getters
-    QString id() const { return m_id; }
-    QString inputPath() const { return m_inputPath; }
-    QString outputPath() const { return m_outputPath; }
+    JobId id() const { return m_id; }
+    QString inputPath() const;
+    QString outputPath() const;
     JobType type() const { return m_type; }
-    JobStatus status() const { return m_status; }
-    int progress() const { return m_progress; }
-    QString errorMessage() const { return m_errorMessage; }
+    JobStatus status() const { return m_status.load(std::memory_order_acquire); }
+    JobPriority priority() const { return m_priority; }
+    
+    // Shared, read-only settings snapshot of the batch this job belongs to
+    const EncodeProfile& profile() const { return *m_profile; }
+    int progress() const { return qMax(0, m_progress.load(std::memory_order_relaxed)); }
+    QString errorMessage() const;
     
     qint64 inputSize() const { return m_inputSize; }
-    qint64 outputSize() const { return m_outputSize; }
+    qint64 outputSize() const { return m_cold ? m_cold->outputSize : 0; }
     
-    QDateTime startTime() const { return m_startTime; }
-    QDateTime endTime() const { return m_endTime; }
+    // Wall time between Processing and a final state, from a monotonic clock
     qint64 processingTimeMs() const;
     
-    QString inputFormat() const { return m_inputFormat; }
-    QString outputFormat() const { return m_outputFormat; }
+    QString inputFormat() const;
+    QString outputFormat() const { return formatName(m_outputFormat); }
+    MediaFormat outputMediaFormat() const { return m_outputFormat; }
+    QString outputChecksum() const;
+    
+    static MediaFormat formatFromName(const QString& name);
+    static QString formatName(MediaFormat format);
+    
+    // Threads the job's encoder may use, granted by the queue's CpuBudget; the
+    // queue may raise it while the job runs, so encoders re-read it between passes
+    int threadBudget() const { return m_threadBudget.load(std::memory_order_relaxed); }
+    
+    // Live encoder throughput reported by the video processor; 0 while unknown
+    double encodeFps() const;
+    double encodeSpeed() const;
+    void setEncodeRate(double fps, double speed);
+    
+    // Estimated encode time in core-seconds, used by size-aware scheduling and the ETA
+    double costEstimate() const { return m_costEstimate.load(std::memory_order_relaxed); }
+    
+    // Cancellation token polled by processors from the worker thread
+    bool isCancelRequested() const { return m_control.load(std::memory_order_acquire) & CancelRequested; }
+    void requestCancel();
+    
+    // Pause token; the job stays Processing while its encoder is suspended
+    bool isPauseRequested() const { return m_control.load(std::memory_order_acquire) & PauseRequested; }
+    void requestPause();
+    void requestResume();
+    
+    // Blocks an in-process encode at a safe point until resumed or cancelled
+    void waitWhilePaused() const;
 
     // Setters
-    void setOutputPath(const QString& path) { m_outputPath = path; }
     void setStatus(JobStatus status);
+    void setPriority(JobPriority priority) { m_priority = priority; }
     void setProgress(int progress);
+    
+    // Swaps in @p progress and reports the replaced value in @p previous; refused
+    // once the job's progress has been retired
+    bool advanceProgress(int progress, int& previous);
+    
+    // Zeroes progress for good and returns what it was, so a runner reporting after
+    // a stop or failure cannot add its delta back into the queue's totals
+    int retireProgress();
     void setError(const QString& error);
-    void setOutputSize(qint64 size) { m_outputSize = size; }
-    void setOutputFormat(const QString& format) { m_outputFormat = format; }
+    void setOutputSize(qint64 size) { cold().outputSize = size; }
+    void setOutputFormat(const QString& format) { m_outputFormat = formatFromName(format); }
+    void setOutputChecksum(const QString& checksum);
+    void setThreadBudget(int threads) { m_threadBudget.store(threads, std::memory_order_relaxed); }
+    void setCostEstimate(double cost) { m_costEstimate.store(static_cast<float>(cost), std::memory_order_relaxed); }
 
 private:
-    void determineJobType();
-    void generateOutputPath(const Settings& settings);
-    QString generateJobId() const;
+    void determineJobType(const QString& name);
+    void generateOutputPath(const QString& name);
+    static JobId generateJobId();
+    static qint64 monotonicMs();
 
-private:
-    QString m_id;
-    QString m_inputPath;
-    QString m_outputPath;
-    QString m_inputFormat;
-    QString m_outputFormat;
-    
-    JobType m_type = JobType::Unknown;
-    JobStatus m_status = JobStatus::Pending;
-    int m_progress = 0;
-    QString m_errorMessage;
+    QString inputName() const;
+
+    // Fields only a started or finished job needs. Allocated when the job starts,
+    // on the queue's thread, so the worker never allocates it; otherwise on first write
+    struct ColdData {
+        QString errorMessage;
+        QString outputChecksum;
+        qint64 outputSize = 0;
+        
+        // Monotonic milliseconds, -1 until set
+        qint64 startMs = -1;
+        qint64 endMs = -1;
+        
+        std::atomic<float> encodeFps{0};
+        std::atomic<float> encodeSpeed{0};
+    };
+    ColdData& cold();
     
+    enum ControlFlag : quint8 {
+        CancelRequested = 0x1,
+        PauseRequested = 0x2
+    };
+
+private:
+    EncodeProfilePtr m_profile;
+    std::unique_ptr<ColdData> m_cold;
     qint64 m_inputSize = 0;
-    qint64 m_outputSize = 0;
+    std::atomic<float> m_costEstimate{0};
     
-    QDateTime m_startTime;
-    QDateTime m_endTime;
+    // Directories and file names live in PathPool; the output name is derived from the input
+    JobId m_id = 0;
+    quint32 m_inputDir = 0;
+    quint32 m_inputName = 0;
+    quint32 m_outputDir = 0;
+    std::atomic<int> m_progress{0};
+    static constexpr int RetiredProgress = -1;
+    std::atomic<int> m_threadBudget{1};
+    
+    JobType m_type = JobType::Unknown;
+    std::atomic<JobStatus> m_status{JobStatus::Pending};  // written under the queue lock, read anywhere
+    JobPriority m_priority = JobPriority::Normal;
+    MediaFormat m_outputFormat = MediaFormat::Unknown;
+    bool m_inPlace = false;
+    std::atomic<quint8> m_control{0};
 };
 
 #endif // JOB_H
@@ -0,0 +1,355 @@
+/**
+ * @file JobJournal.cpp
+ * @brief Append-only on-disk journal implementation
+ */
+
+#include "JobJournal.h"
+#include "FileUtils.h"
+#include "Logger.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+JobJournal::JobJournal(const QString& path)
+    : m_path(path)
+{
+    m_syncPool.setMaxThreadCount(1);
+}
+
+JobJournal::~JobJournal()
+{
+    close();
+}
+
+QString JobJournal::defaultPath()
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QString("%1/queue.journal").arg(dataDir);
+}
+
+bool JobJournal::open()
+{
+    close();
+    
+    replay();
+    
+    // Rewrite as one record per input so the journal never grows across runs
+    if (!m_entries.isEmpty() && !compact()) {
+        Logger::warning("Failed to compact job journal: " + m_path);
+    }
+    
+    FileUtils::ensureDirectoryExists(QFileInfo(m_path).absolutePath());
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        Logger::error("Failed to open job journal: " + m_file.errorString());
+        return false;
+    }
+    
+    if (hasUnfinishedWork()) {
+        Logger::info(QString("Job journal holds an interrupted batch of %1 file(s)")
+            .arg(resumableInputs().count()));
+    }
+    return true;
+}
+
+void JobJournal::close()
+{
+    // A queued sync still uses the file handle
+    m_syncPool.waitForDone();
+    
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void JobJournal::recordEnqueued(const Job& job)
+{
+    QJsonObject record;
+    record["event"] = statusName(JobStatus::Pending);
+    record["input"] = job.inputPath();
+    record["output"] = job.outputPath();
+    record["inputSize"] = job.inputSize();
+    
+    apply(record);
+    append(record, Durability::Buffered);
+}
+
+void JobJournal::recordStarted(const Job& job)
+{
+    QJsonObject record;
+    record["event"] = statusName(JobStatus::Processing);
+    record["input"] = job.inputPath();
+    
+    apply(record);
+    append(record, Durability::Flushed);
+}
+
+void JobJournal::recordCompleted(const Job& job)
+{
+    QJsonObject record;
+    record["event"] = statusName(JobStatus::Completed);
+    record["input"] = job.inputPath();
+    record["output"] = job.outputPath();
+    record["outputSize"] = job.outputSize();
+    record["checksum"] = job.outputChecksum();
+    
+    // Completions are what a resume skips, so they must survive a power loss;
+    // the sync is batched off the caller's thread
+    apply(record);
+    append(record, Durability::Synced);
+}
+
+void JobJournal::recordFailed(const Job& job)
+{
+    QJsonObject record;
+    record["event"] = statusName(JobStatus::Failed);
+    record["input"] = job.inputPath();
+    record["error"] = job.errorMessage();
+    
+    apply(record);
+    append(record, Durability::Synced);
+}
+
+void JobJournal::recordCancelled(const Job& job)
+{
+    QJsonObject record;
+    record["event"] = statusName(JobStatus::Cancelled);
+    record["input"] = job.inputPath();
+    
+    apply(record);
+    append(record, Durability::Flushed);
+}
+
+QString JobJournal::completedOutput(const Job& job) const
+{
+    auto it = m_entries.constFind(job.inputPath());
+    if (it == m_entries.constEnd()) return QString();
+    
+    const JournalEntry& recorded = it.value();
+    if (recorded.status != JobStatus::Completed) return QString();
+    
+    // Settings or the source may have changed since; only trust an identical job.
+    // An in-place job's input is its own earlier output, so it has the output's size
+    if (recorded.outputPath != job.outputPath()) return QString();
+    if (recorded.outputPath == job.inputPath()) {
+        if (job.inputSize() != recorded.outputSize) return QString();
+    } else if (recorded.inputSize != 0 && recorded.inputSize != job.inputSize()) {
+        return QString();
+    }
+    
+    QFileInfo output(recorded.outputPath);
+    if (!output.exists() || output.size() != recorded.outputSize) return QString();
+    
+    return recorded.outputPath;
+}
+
+bool JobJournal::isCompleted(const Job& job, const QString& outputChecksum,
+                             JournalEntry* entry) const
+{
+    if (completedOutput(job).isEmpty()) return false;
+    
+    // Journals without checksums fall back to the size checks, except in place,
+    // where a same-sized input could just as well be an unconverted original
+    const JournalEntry recorded = m_entries.value(job.inputPath());
+    if (recorded.checksum.isEmpty() ? recorded.outputPath == job.inputPath()
+                                    : recorded.checksum != outputChecksum) {
+        return false;
+    }
+    
+    if (entry) {
+        *entry = recorded;
+    }
+    return true;
+}
+
+QStringList JobJournal::resumableInputs() const
+{
+    QStringList inputs;
+    for (const QString& input : m_order) {
+        if (m_entries.value(input).status != JobStatus::Cancelled && QFileInfo::exists(input)) {
+            inputs.append(input);
+        }
+    }
+    return inputs;
+}
+
+bool JobJournal::hasUnfinishedWork() const
+{
+    for (const auto& entry : m_entries) {
+        if (entry.status == JobStatus::Pending ||
+            entry.status == JobStatus::Processing ||
+            entry.status == JobStatus::Paused) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobJournal::reset()
+{
+    m_entries.clear();
+    m_order.clear();
+    
+    if (m_file.isOpen()) {
+        m_file.resize(0);
+    }
+}
+
+void JobJournal::replay()
+{
+    m_entries.clear();
+    m_order.clear();
+    
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    int skipped = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        
+        // A crash can leave the last record half written
+        QJsonDocument doc = QJsonDocument::fromJson(line);
+        if (!doc.isObject()) {
+            skipped++;
+            continue;
+        }
+        apply(doc.object());
+    }
+    
+    if (skipped > 0) {
+        Logger::warning(QString("Skipped %1 damaged job journal record(s)").arg(skipped));
+    }
+}
+
+bool JobJournal::compact()
+{
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    
+    for (const QString& input : m_order) {
+        const JournalEntry& entry = m_entries[input];
+        
+        QJsonObject record;
+        record["event"] = statusName(entry.status);
+        record["input"] = input;
+        record["output"] = entry.outputPath;
+        record["inputSize"] = entry.inputSize;
+        record["outputSize"] = entry.outputSize;
+        record["checksum"] = entry.checksum;
+        if (!entry.error.isEmpty()) {
+            record["error"] = entry.error;
+        }
+        
+        file.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+        file.write("\n");
+    }
+    
+    return file.commit();
+}
+
+void JobJournal::flush()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+}
+
+void JobJournal::append(const QJsonObject& record, Durability durability)
+{
+    if (!m_file.isOpen()) return;
+    
+    m_file.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    if (durability == Durability::Buffered) return;
+    
+    m_file.flush();
+    
+    // Syncing also persists every record appended before this one
+    if (durability == Durability::Synced) {
+        requestSync();
+    }
+}
+
+void JobJournal::requestSync()
+{
+    // Records written while a sync is queued ride along with it
+    if (m_syncQueued.exchange(true)) return;
+    
+    int handle = m_file.handle();
+    m_syncPool.start([this, handle]() {
+        m_syncQueued = false;
+#ifdef Q_OS_WIN
+        _commit(handle);
+#else
+        ::fsync(handle);
+#endif
+    });
+}
+
+void JobJournal::apply(const QJsonObject& record)
+{
+    QString input = record["input"].toString();
+    if (input.isEmpty()) return;
+    
+    JournalEntry& entry = entryFor(input);
+    entry.status = statusFromName(record["event"].toString());
+    
+    if (record.contains("output")) {
+        entry.outputPath = record["output"].toString();
+    }
+    if (record.contains("inputSize")) {
+        entry.inputSize = record["inputSize"].toInteger();
+    }
+    if (record.contains("outputSize")) {
+        entry.outputSize = record["outputSize"].toInteger();
+    }
+    if (record.contains("checksum")) {
+        entry.checksum = record["checksum"].toString();
+    }
+    if (record.contains("error")) {
+        entry.error = record["error"].toString();
+    }
+}
+
+JournalEntry& JobJournal::entryFor(const QString& inputPath)
+{
+    auto it = m_entries.find(inputPath);
+    if (it == m_entries.end()) {
+        m_order.append(inputPath);
+        it = m_entries.insert(inputPath, JournalEntry());
+    }
+    return it.value();
+}
+
+QString JobJournal::statusName(JobStatus status)
+{
+    switch (status) {
+        case JobStatus::Pending:    return "enqueued";
+        case JobStatus::Processing: return "started";
+        case JobStatus::Paused:     return "paused";
+        case JobStatus::Completed:  return "completed";
+        case JobStatus::Failed:     return "failed";
+        case JobStatus::Cancelled:  return "cancelled";
+    }
+    return "enqueued";
+}
+
+JobStatus JobJournal::statusFromName(const QString& name)
+{
+    if (name == "started") return JobStatus::Processing;
+    if (name == "paused") return JobStatus::Paused;
+    if (name == "completed") return JobStatus::Completed;
+    if (name == "failed") return JobStatus::Failed;
+    if (name == "cancelled") return JobStatus::Cancelled;
+    return JobStatus::Pending;
+}
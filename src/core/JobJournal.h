@@ -0,0 +1,94 @@
+/**
+ * @file JobJournal.h
+ * @brief Append-only on-disk journal of job state transitions
+ */
+
+#ifndef JOBJOURNAL_H
+#define JOBJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QFile>
+#include <QThreadPool>
+#include <atomic>
+
+#include "Job.h"
+
+class QJsonObject;
+
+// Last known state of one input file in the journalled batch
+struct JournalEntry {
+    JobStatus status = JobStatus::Pending;
+    QString outputPath;
+    qint64 inputSize = 0;
+    qint64 outputSize = 0;
+    QString checksum;
+    QString error;
+};
+
+// Not thread-safe; JobQueue serialises every call under its own mutex
+class JobJournal
+{
+public:
+    explicit JobJournal(const QString& path = defaultPath());
+    ~JobJournal();
+
+    static QString defaultPath();
+    
+    // Replays and compacts any existing journal, then opens it for appending
+    bool open();
+    void close();
+    
+    // Enqueue records are buffered until flush(); bulk ingest flushes once
+    void recordEnqueued(const Job& job);
+    void recordStarted(const Job& job);
+    void recordCompleted(const Job& job);
+    void recordFailed(const Job& job);
+    void recordCancelled(const Job& job);
+    void flush();
+    
+    // Output a previous run finished for this job, when it still has the recorded size;
+    // empty otherwise. Callers checksum it outside their lock for isCompleted()
+    QString completedOutput(const Job& job) const;
+    
+    // True when completedOutput() holds and @p outputChecksum matches the recorded one
+    bool isCompleted(const Job& job, const QString& outputChecksum,
+                     JournalEntry* entry = nullptr) const;
+    
+    // Inputs of an interrupted batch in enqueue order, excluding cancelled or missing ones
+    QStringList resumableInputs() const;
+    bool hasUnfinishedWork() const;
+    
+    // Forget the batch once it has run to the end
+    void reset();
+
+private:
+    enum class Durability {
+        Buffered,
+        Flushed,
+        Synced
+    };
+
+    void replay();
+    bool compact();
+    void append(const QJsonObject& record, Durability durability);
+    void requestSync();
+    void apply(const QJsonObject& record);
+    JournalEntry& entryFor(const QString& inputPath);
+    
+    static QString statusName(JobStatus status);
+    static JobStatus statusFromName(const QString& name);
+
+private:
+    QString m_path;
+    QFile m_file;
+    QHash<QString, JournalEntry> m_entries;
+    QStringList m_order;
+    
+    // fsync runs on its own thread and coalesces: a burst of completions costs one sync
+    QThreadPool m_syncPool;
+    std::atomic<bool> m_syncQueued{false};
+};
+
+#endif // JOBJOURNAL_H
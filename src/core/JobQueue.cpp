@@ -5,19 +5,44 @@
 
 #include "JobQueue.h"
 #include "Settings.h"
+#include "MediaInfo.h"
 #include "ImageProcessor.h"
 #include "VideoProcessor.h"
 #include "Logger.h"
+#include "FileUtils.h"
+#include "ContentHasher.h"
+#include "SampleEstimator.h"
+#include "ThroughputHistory.h"
 
 #include <QRunnable>
 #include <QThread>
+#include <QFile>
+#include <QDateTime>
+#include <QtConcurrent>
+
+namespace {
+
+// What the cost models scale with: pixels for videos, bytes for images; until a
+// video is probed, guess from its size at roughly 0.1 bits per pixel
+double workUnits(const Job& job, const VideoInfo* info)
+{
+    if (job.type() != JobType::Video) return static_cast<double>(job.inputSize());
+    
+    if (info && info->duration > 0 && info->width > 0 && info->height > 0) {
+        double fps = info->fps > 0 ? info->fps : 30.0;
+        return info->duration * fps * info->width * info->height;
+    }
+    return job.inputSize() * 80.0;
+}
+
+} // namespace
 
 class JobRunner : public QRunnable
 {
 public:
     JobRunner(std::shared_ptr<Job> job, 
-              std::function<void(const QString&, int)> progressCallback,
-              std::function<void(const QString&, bool, const QString&)> finishedCallback)
+              std::function<void(JobId, int)> progressCallback,
+              std::function<void(JobId, bool, const QString&)> finishedCallback)
         : m_job(job)
         , m_progressCallback(progressCallback)
         , m_finishedCallback(finishedCallback)
@@ -27,11 +52,18 @@ public:
     {
         if (!m_job) return;
         
-        m_job->setStatus(JobStatus::Processing);
-        
         bool success = false;
+        bool remuxed = false;
+        int crf = -1;
+        QString contentClass;
         QString error;
         
+        // Stopped between dispatch and a pool thread picking the job up
+        if (m_job->isCancelRequested()) {
+            m_finishedCallback(m_job->id(), false, "Cancelled");
+            return;
+        }
+        
         try {
             if (m_job->type() == JobType::Image) {
                 ImageProcessor processor;
@@ -48,6 +80,9 @@ public:
                     m_progressCallback(m_job->id(), progress);
                 });
                 success = processor.process(m_job.get());
+                remuxed = processor.copiedVideo();
+                crf = processor.crf();
+                contentClass = processor.contentClass();
                 if (!success) {
                     error = processor.lastError();
                 }
@@ -58,42 +93,257 @@ public:
             error = QString::fromStdString(e.what());
         }
         
+        // Hashed here, off the GUI thread, for the journal's completion record
+        if (success) {
+            m_job->setOutputChecksum(FileUtils::fileChecksum(m_job->outputPath()));
+            
+            // A remux says nothing about the encoder's speed
+            if (!remuxed) recordThroughput(crf, contentClass);
+        } else if (m_job->isCancelRequested()) {
+            discardPartialOutput();
+        }
+        
         m_finishedCallback(m_job->id(), success, error);
     }
 
 private:
+    void recordThroughput(int crf, const QString& contentClass)
+    {
+        ThroughputRecord record;
+        record.crf = crf;
+        record.contentClass = contentClass;
+        record.profileKey = ThroughputHistory::profileKey(*m_job);
+        record.timestamp = QDateTime::currentMSecsSinceEpoch();
+        record.inputBytes = m_job->inputSize();
+        record.outputBytes = m_job->outputSize();
+        record.threads = m_job->threadBudget();
+        record.hostCores = QThread::idealThreadCount();
+        record.coreSeconds = m_job->processingTimeMs() / 1000.0 * record.threads;
+        
+        VideoInfo info;
+        if (m_job->type() == JobType::Video) {
+            // Cached since the cost probe
+            info = MediaInfo::getVideoInfo(m_job->inputPath(), m_job->profile().ffmpegPath);
+            record.width = info.width;
+            record.height = info.height;
+            record.duration = info.duration;
+        }
+        record.work = workUnits(*m_job, &info);
+        
+        ThroughputHistory::instance().record(record);
+    }
+
+    void discardPartialOutput()
+    {
+        // Never delete the source when the job was writing over it
+        QString outputPath = m_job->outputPath();
+        if (outputPath != m_job->inputPath() && QFile::exists(outputPath)) {
+            QFile::remove(outputPath);
+        }
+    }
+
     std::shared_ptr<Job> m_job;
-    std::function<void(const QString&, int)> m_progressCallback;
-    std::function<void(const QString&, bool, const QString&)> m_finishedCallback;
+    std::function<void(JobId, int)> m_progressCallback;
+    std::function<void(JobId, bool, const QString&)> m_finishedCallback;
 };
 
 JobQueue::JobQueue(QObject *parent)
     : QObject(parent)
 {
     m_threadPool = new QThreadPool(this);
-    m_threadPool->setMaxThreadCount(m_maxConcurrentJobs);
+    
+    // Worker progress is coalesced and published at a fixed rate
+    m_progressBus = new ProgressBus(this);
+    connect(m_progressBus, &ProgressBus::jobsProgressed,
+            this, [this](const QVector<JobProgressUpdate>& updates) {
+        emit jobsProgressed(updates);
+        emit progressChanged(totalProgress());
+    });
+    
+    m_probeWatcher = new QFutureWatcher<void>(this);
+    connect(m_probeWatcher, &QFutureWatcher<void>::finished,
+            this, &JobQueue::onVideoCostsProbed);
+    
+    m_hashWatcher = new QFutureWatcher<void>(this);
+    
+    // Followers' outputs are linked or copied here; a cross-volume copy of a large
+    // video must not hold m_mutex or occupy an encode slot
+    m_sharePool = new QThreadPool(this);
+    m_sharePool->setMaxThreadCount(2);
+    connect(m_hashWatcher, &QFutureWatcher<void>::finished,
+            this, &JobQueue::onInputsHashed);
+    
+    m_journal.open();
 }
 
 JobQueue::~JobQueue()
 {
+    m_probeWatcher->waitForFinished();
+    m_hashWatcher->waitForFinished();
     stopAll();
+    
+    // Runners reference this queue; cancelled children exit within milliseconds
+    m_threadPool->waitForDone();
+    m_sharePool->waitForDone();
+    ThroughputHistory::instance().save();
 }
 
-void JobQueue::addJob(const QString& filePath, const Settings& settings)
+void JobQueue::addJob(const QString& filePath, EncodeProfilePtr profile, JobPriority priority)
 {
+    auto job = std::make_shared<Job>(filePath, std::move(profile));
+    job->setPriority(priority);
+    job->setCostEstimate(estimateCost(*job));
+    QHash<JobId, QString> checksums = completedOutputChecksums({job});
+    
     QMutexLocker locker(&m_mutex);
     
-    auto job = std::make_shared<Job>(filePath, settings);
-    m_jobs.append(job);
+    bool alreadyDone = insertJob(job, checksums.value(job->id()));
+    m_journal.flush();
     
+    bool processing = m_isProcessing;
+    locker.unlock();
     emit jobAdded(job->id());
+    
+    if (alreadyDone) {
+        Logger::info("Skipping already completed file: " + filePath);
+        emit jobCompleted(job->id());
+    } else if (processing) {
+        // Jobs added mid-run start as soon as their lane has room
+        dispatchJobs();
+    }
+}
+
+void JobQueue::addJob(const QString& filePath, const Settings& settings, JobPriority priority)
+{
+    addJob(filePath, EncodeProfile::fromSettings(settings), priority);
 }
 
-void JobQueue::addJobs(const QStringList& filePaths, const Settings& settings)
+void JobQueue::addJobs(const QStringList& filePaths, const Settings& settings, JobPriority priority)
 {
-    for (const QString& path : filePaths) {
-        addJob(path, settings);
+    addJobs(filePaths, EncodeProfile::fromSettings(settings), priority);
+}
+
+void JobQueue::addJobs(const QStringList& filePaths, EncodeProfilePtr profile, JobPriority priority)
+{
+    if (filePaths.isEmpty()) return;
+    
+    // Stat, classify and id every file on the pool, outside the lock
+    auto created = QtConcurrent::blockingMapped<QList<std::shared_ptr<Job>>>(filePaths,
+        [profile, priority](const QString& path) {
+            auto job = std::make_shared<Job>(path, profile);
+            job->setPriority(priority);
+            job->setCostEstimate(estimateCost(*job));
+            return job;
+        });
+    QHash<JobId, QString> checksums = completedOutputChecksums(created);
+    
+    QMutexLocker locker(&m_mutex);
+    
+    int first = m_jobs.size();
+    m_jobs.reserve(first + created.size());
+    m_jobIndex.reserve(first + created.size());
+    
+    int skipped = 0;
+    for (const auto& job : created) {
+        if (insertJob(job, checksums.value(job->id()))) {
+            skipped++;
+        }
     }
+    m_journal.flush();
+    
+    bool processing = m_isProcessing;
+    locker.unlock();
+    
+    if (skipped > 0) {
+        Logger::info(QString("Skipping %1 already completed file(s)").arg(skipped));
+    }
+    
+    // Listeners read the new jobs, including their status, through jobs(first, count)
+    emit jobsAdded(first, created.size());
+    
+    if (processing) {
+        dispatchJobs();
+    }
+}
+
+QHash<JobId, QString> JobQueue::completedOutputChecksums(const QList<std::shared_ptr<Job>>& jobs)
+{
+    QList<QPair<JobId, QString>> outputs;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto& job : jobs) {
+            QString output = m_journal.completedOutput(*job);
+            if (!output.isEmpty()) {
+                outputs.append(qMakePair(job->id(), output));
+            }
+        }
+    }
+    if (outputs.isEmpty()) return {};
+    
+    // Read in parallel and outside the lock; cached by path, size and mtime for later resumes
+    auto digests = QtConcurrent::blockingMapped<QList<QString>>(outputs,
+        [](const QPair<JobId, QString>& output) {
+            return ContentHasher::instance().hash(output.second);
+        });
+    ContentHasher::instance().save();
+    
+    QHash<JobId, QString> checksums;
+    for (int i = 0; i < outputs.size(); ++i) {
+        checksums.insert(outputs[i].first, digests[i]);
+    }
+    return checksums;
+}
+
+bool JobQueue::insertJob(const std::shared_ptr<Job>& job, const QString& outputChecksum)
+{
+    // Work finished before a crash or exit is taken over instead of re-encoded
+    JournalEntry finished;
+    bool alreadyDone = m_journal.isCompleted(*job, outputChecksum, &finished);
+    if (alreadyDone) {
+        job->setStatus(JobStatus::Completed);
+        job->setOutputSize(finished.outputSize);
+        job->setOutputChecksum(finished.checksum);
+        job->setProgress(100);
+    }
+    
+    m_jobs.append(job);
+    m_jobIndex.insert(job->id(), m_jobs.size() - 1);
+    m_statusCounts[static_cast<int>(job->status())]++;
+    m_totalJobs++;
+    m_totalInputSize += job->inputSize();
+    
+    if (alreadyDone) {
+        m_totalOutputSize += job->outputSize();
+        m_progressSum += 100;
+    } else {
+        m_journal.recordEnqueued(*job);
+        enqueueReady(job);
+    }
+    
+    return alreadyDone;
+}
+
+bool JobQueue::setJobPriority(JobId jobId, JobPriority priority)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    std::shared_ptr<Job> job = findJob(jobId);
+    if (!job || job->status() != JobStatus::Pending) return false;
+    if (job->priority() == priority) return true;
+    
+    Lane oldLane = laneFor(*job);
+    job->setPriority(priority);
+    Lane newLane = laneFor(*job);
+    
+    // Rebuilding re-keys the job in place, or drops it from a lane it has left
+    rebuildReadyQueue(oldLane);
+    if (newLane != oldLane) {
+        enqueueReady(job);
+    }
+    
+    locker.unlock();
+    dispatchJobs();
+    return true;
 }
 
 void JobQueue::start()
@@ -105,23 +355,90 @@ void JobQueue::start()
     
     m_isProcessing = true;
     m_isPaused = false;
-    m_currentJobIndex = 0;
     
-    // Set thread count from settings
-    m_threadPool->setMaxThreadCount(Settings::instance().threadCount());
+    // Size the lanes from settings; the pool holds exactly one thread per slot
+    const auto& settings = Settings::instance();
+    m_laneBudgets[ImageLane] = qMax(1, settings.maxImageJobs());
+    m_laneBudgets[VideoLane] = qMax(1, settings.maxVideoJobs());
+    m_laneBudgets[ExpressLane] = qMax(1, settings.expressSlots());
+    m_threadPool->setMaxThreadCount(m_laneBudgets[ImageLane] + m_laneBudgets[VideoLane] +
+                                    m_laneBudgets[ExpressLane]);
+    m_preemptForExpress = settings.preemptForExpress();
+    
+    // Encoder threads are split across running jobs instead of each taking every core
+    m_cpuBudget.setTotalThreads(settings.threadCount());
+    
+    // libvips has one process-wide thread setting; every image slot gets an equal share.
+    // Without videos the image lane also runs in the video slots
+    bool hasVideos = false;
+    for (const auto& job : std::as_const(m_jobs)) {
+        if (job->type() == JobType::Video && job->status() == JobStatus::Pending) {
+            hasVideos = true;
+            break;
+        }
+    }
+    int imageSlots = m_laneBudgets[ImageLane] + (hasVideos ? 0 : m_laneBudgets[VideoLane]);
+    ImageProcessor::setConcurrency(m_cpuBudget.totalThreads() / imageSlots);
+    
+    Logger::info(QString("Job queue slots: %1 image, %2 video, %3 express, %4 CPU threads")
+        .arg(m_laneBudgets[ImageLane]).arg(m_laneBudgets[VideoLane])
+        .arg(m_laneBudgets[ExpressLane]).arg(m_cpuBudget.totalThreads()));
     
     locker.unlock();
     
+    setSchedulingPolicy(policyFromString(settings.schedulingPolicy()));
+    findDuplicateInputs();
+    
     // Start processing
-    processNextJob();
+    m_progressBus->start();
+    dispatchJobs();
     
     Logger::info("Job queue started");
 }
 
+void JobQueue::setSchedulingPolicy(SchedulingPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    m_policy = policy;
+    for (int lane = 0; lane < LaneCount; ++lane) {
+        rebuildReadyQueue(static_cast<Lane>(lane));
+    }
+    
+    locker.unlock();
+    
+    // Size-aware orders need real durations for the videos still waiting
+    if (policy != SchedulingPolicy::Fifo) {
+        probeVideoCosts();
+    }
+}
+
+SchedulingPolicy JobQueue::schedulingPolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policy;
+}
+
+SchedulingPolicy JobQueue::policyFromString(const QString& name)
+{
+    if (name == "longest_first") {
+        return SchedulingPolicy::LongestFirst;
+    } else if (name == "shortest_first") {
+        return SchedulingPolicy::ShortestFirst;
+    }
+    return SchedulingPolicy::Fifo;
+}
+
 void JobQueue::pause()
 {
     QMutexLocker locker(&m_mutex);
     m_isPaused = true;
+    
+    // Running encoders are suspended in place rather than left to finish
+    for (const auto& job : m_runningJobs) {
+        job->requestPause();
+    }
+    
     Logger::info("Job queue paused");
 }
 
@@ -129,10 +446,25 @@ void JobQueue::resume()
 {
     QMutexLocker locker(&m_mutex);
     m_isPaused = false;
+    
+    // Jobs preempted by a running express job stay suspended until it ends
+    for (const auto& job : m_runningJobs) {
+        bool preempted = false;
+        for (const auto& victim : m_preemptedBy) {
+            if (victim == job) {
+                preempted = true;
+                break;
+            }
+        }
+        if (!preempted) {
+            job->requestResume();
+        }
+    }
+    
     Logger::info("Job queue resumed");
     
     locker.unlock();
-    processNextJob();
+    dispatchJobs();
 }
 
 void JobQueue::stopAll()
@@ -142,97 +474,126 @@ void JobQueue::stopAll()
     m_isProcessing = false;
     m_isPaused = false;
     
+    m_progressBus->stop();
     m_threadPool->clear();
-    m_threadPool->waitForDone();
     
-    // Mark processing jobs as cancelled
-    for (auto& job : m_jobs) {
+    // Signal running jobs and return at once; their runners kill the children
+    // and report back later, when onJobFinished() ignores them.
+    // The journal keeps them resumable.
+    for (const auto& job : std::as_const(m_runningJobs)) {
         if (job->status() == JobStatus::Processing) {
+            job->requestCancel();
             job->setStatus(JobStatus::Cancelled);
+            updateStatusCounts(JobStatus::Processing, JobStatus::Cancelled);
+            m_progressSum -= job->retireProgress();
         }
     }
     
+    m_runningCounts.fill(0);
+    m_borrowedSlots.clear();
+    m_runningJobs.clear();
+    m_preemptedBy.clear();
+    m_lentThreads.clear();
+    releaseFollowers();
+    m_cpuBudget.reset();
+    m_activeWeight = 0;
+    
     Logger::info("Job queue stopped");
 }
 
-void JobQueue::cancel(const QString& jobId)
+void JobQueue::cancel(JobId jobId)
 {
     QMutexLocker locker(&m_mutex);
     
-    for (auto& job : m_jobs) {
-        if (job->id() == jobId) {
-            if (job->status() == JobStatus::Pending) {
-                job->setStatus(JobStatus::Cancelled);
-            }
-            break;
-        }
+    std::shared_ptr<Job> job = findJob(jobId);
+    if (!job) return;
+    
+    // Cancelled entries stay in the ready queue and are skipped on dispatch
+    if (job->status() == JobStatus::Pending) {
+        job->setStatus(JobStatus::Cancelled);
+        updateStatusCounts(JobStatus::Pending, JobStatus::Cancelled);
+        m_journal.recordCancelled(*job);
+    } else if (job->status() == JobStatus::Processing) {
+        // The runner stops the encoder and onJobFinished() frees the slot
+        job->requestCancel();
     }
 }
 
 int JobQueue::totalProgress() const
 {
-    QMutexLocker locker(&m_mutex);
-    
-    if (m_jobs.isEmpty()) return 0;
+    int total = m_totalJobs.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
     
-    int totalProgress = 0;
-    int completedCount = 0;
+    // Completed jobs contribute 100, running jobs their current progress
+    return static_cast<int>(m_progressSum.load(std::memory_order_relaxed) / total);
+}
+
+double JobQueue::estimatedRemainingSeconds(JobId jobId) const
+{
+    QMutexLocker locker(&m_mutex);
     
-    for (const auto& job : m_jobs) {
-        if (job->status() == JobStatus::Completed) {
-            totalProgress += 100;
-            completedCount++;
-        } else if (job->status() == JobStatus::Processing) {
-            totalProgress += job->progress();
-        }
+    std::shared_ptr<Job> running = findJob(jobId);
+    if (!running || running->status() != JobStatus::Processing) {
+        return -1;
     }
     
-    return totalProgress / m_jobs.size();
+    const Job& job = *running;
+    return remainingCoreSeconds(job) / qMax(1, job.threadBudget());
 }
 
-JobStatistics JobQueue::statistics() const
+double JobQueue::remainingCoreSeconds(const Job& job) const
 {
-    QMutexLocker locker(&m_mutex);
+    int progress = job.progress();
+    double modelled = job.costEstimate() * (100 - progress) / 100.0;
+    if (job.status() != JobStatus::Processing || progress <= 0) return modelled;
     
-    JobStatistics stats;
-    stats.total = m_jobs.size();
+    // The job's own pace takes over from the model as it accumulates
+    double elapsed = job.processingTimeMs() / 1000.0 * job.threadBudget();
+    double measured = elapsed * (100 - progress) / progress;
+    double weight = progress / 100.0;
+    return modelled * (1.0 - weight) + measured * weight;
+}
+
+double JobQueue::estimatedRemainingSeconds() const
+{
+    QMutexLocker locker(&m_mutex);
     
+    double coreSeconds = 0;
     for (const auto& job : m_jobs) {
-        stats.totalInputSize += job->inputSize();
-        
-        switch (job->status()) {
-            case JobStatus::Completed:
-                stats.completed++;
-                stats.totalOutputSize += job->outputSize();
-                stats.totalTimeMs += job->processingTimeMs();
-                break;
-            case JobStatus::Failed:
-                stats.failed++;
-                break;
-            case JobStatus::Pending:
-                stats.pending++;
-                break;
-            case JobStatus::Processing:
-                stats.processing++;
-                break;
-            default:
-                break;
+        JobStatus status = job->status();
+        if (status != JobStatus::Pending && status != JobStatus::Processing &&
+            status != JobStatus::Paused) {
+            continue;
         }
+        
+        // Duplicates reuse their leader's output
+        if (m_leaderOf.contains(job->id())) continue;
+        
+        coreSeconds += remainingCoreSeconds(*job);
     }
     
+    return coreSeconds / qMax(1, m_cpuBudget.totalThreads());
+}
+
+JobStatistics JobQueue::statistics() const
+{
+    JobStatistics stats;
+    stats.total = m_totalJobs.load(std::memory_order_relaxed);
+    stats.completed = statusCount(JobStatus::Completed);
+    stats.failed = statusCount(JobStatus::Failed);
+    stats.pending = statusCount(JobStatus::Pending);
+    stats.processing = statusCount(JobStatus::Processing);
+    stats.totalInputSize = m_totalInputSize.load(std::memory_order_relaxed);
+    stats.totalOutputSize = m_totalOutputSize.load(std::memory_order_relaxed);
+    stats.totalTimeMs = m_totalTimeMs.load(std::memory_order_relaxed);
     return stats;
 }
 
-Job* JobQueue::getJob(const QString& jobId) const
+Job* JobQueue::getJob(JobId jobId) const
 {
     QMutexLocker locker(&m_mutex);
     
-    for (const auto& job : m_jobs) {
-        if (job->id() == jobId) {
-            return job.get();
-        }
-    }
-    return nullptr;
+    return findJob(jobId).get();
 }
 
 QList<Job*> JobQueue::allJobs() const
@@ -246,50 +607,129 @@ QList<Job*> JobQueue::allJobs() const
     return result;
 }
 
-int JobQueue::jobCount() const
+QList<Job*> JobQueue::jobs(int first, int count) const
 {
     QMutexLocker locker(&m_mutex);
-    return m_jobs.size();
+    
+    QList<Job*> result;
+    int last = qMin(first + count, static_cast<int>(m_jobs.size()));
+    for (int i = qMax(0, first); i < last; ++i) {
+        result.append(m_jobs[i].get());
+    }
+    return result;
+}
+
+int JobQueue::jobCount() const
+{
+    return m_totalJobs.load(std::memory_order_relaxed);
 }
 
 void JobQueue::clear()
 {
-    QMutexLocker locker(&m_mutex);
-    
     stopAll();
+    
+    QMutexLocker locker(&m_mutex);
     m_jobs.clear();
-    m_currentJobIndex = 0;
+    m_jobIndex.clear();
+    for (auto& queue : m_readyQueues) {
+        queue = ReadyQueue();
+    }
+    m_heldEntries.clear();
+    resetCounters();
+    m_nextSequence = 0;
+}
+
+QStringList JobQueue::resumableFiles() const
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (!m_journal.hasUnfinishedWork()) return QStringList();
+    return m_journal.resumableInputs();
 }
 
-void JobQueue::processNextJob()
+void JobQueue::discardResumableBatch()
+{
+    QMutexLocker locker(&m_mutex);
+    m_journal.reset();
+}
+
+void JobQueue::dispatchJobs()
 {
     if (m_isPaused || !m_isProcessing) return;
     
     QMutexLocker locker(&m_mutex);
     
-    // Find next pending job
-    std::shared_ptr<Job> nextJob;
-    for (auto& job : m_jobs) {
-        if (job->status() == JobStatus::Pending) {
-            nextJob = job;
-            break;
+    // Fill every free slot in every lane while threads last; every job needs at least
+    // one, so the rest wait for a running job to release some. Express jobs go first,
+    // and with preemption they run on the threads of the encode they suspend.
+    // A full batch lane borrows the other one's free slots while that lane is idle
+    static const Lane dispatchOrder[] = {ExpressLane, ImageLane, VideoLane};
+    QList<std::shared_ptr<Job>> started;
+    int claimable = m_cpuBudget.freeThreads();
+    for (Lane lane : dispatchOrder) {
+        // Hold videos back until their probed costs have reordered the lane
+        if (lane == VideoLane && m_probingVideos) continue;
+        
+        for (;;) {
+            Lane slotLane = lane;
+            if (m_runningCounts[lane] >= m_laneBudgets[lane]) {
+                slotLane = lendingLane(lane);
+                if (slotLane == LaneCount) break;
+            }
+            
+            std::shared_ptr<Job> victim;
+            if (lane == ExpressLane && m_preemptForExpress) {
+                victim = preemptionVictim();
+            }
+            if (!victim && claimable <= 0) break;
+            
+            std::shared_ptr<Job> nextJob = takeNextReady(lane);
+            if (!nextJob) break;
+            
+            // Claim the job before releasing the lock so it is never dispatched twice
+            nextJob->setStatus(JobStatus::Processing);
+            updateStatusCounts(JobStatus::Pending, JobStatus::Processing);
+            m_journal.recordStarted(*nextJob);
+            m_runningCounts[slotLane]++;
+            if (slotLane != lane) {
+                m_borrowedSlots.insert(nextJob->id(), slotLane);
+            }
+            m_activeWeight += CpuBudget::weightFor(nextJob->type());
+            m_runningJobs.append(nextJob);
+            started.append(nextJob);
+            
+            if (victim) {
+                preemptFor(nextJob, victim);
+            } else {
+                claimable--;
+            }
         }
     }
     
-    if (!nextJob) {
-        // Check if all jobs are done
-        bool allDone = true;
-        for (const auto& job : m_jobs) {
-            if (job->status() == JobStatus::Processing ||
-                job->status() == JobStatus::Pending) {
-                allDone = false;
-                break;
-            }
-        }
+    // Share the CPU once the full set of running jobs is known; each job keeps one
+    // thread back for every job after it that has nothing lent
+    int reserved = m_cpuBudget.freeThreads() - claimable;
+    for (const auto& job : started) {
+        int lent = m_lentThreads.value(job->id());
+        if (lent == 0) reserved--;
+        job->setThreadBudget(lent + m_cpuBudget.acquire(job->type(), m_activeWeight, qMax(0, reserved)));
+    }
+    
+    // Whatever no new job could take goes to the encodes already running
+    growGrants();
+    
+    if (started.isEmpty()) {
+        bool allDone = statusCount(JobStatus::Processing) == 0 &&
+                       statusCount(JobStatus::Pending) == 0;
         
         if (allDone) {
             m_isProcessing = false;
+            
+            // Nothing left to resume; failures are final for this batch
+            m_journal.reset();
             locker.unlock();
+            m_progressBus->stop();
+            ThroughputHistory::instance().save();
             emit allJobsCompleted();
         }
         return;
@@ -297,52 +737,560 @@ void JobQueue::processNextJob()
     
     locker.unlock();
     
-    emit jobStarted(nextJob->id());
+    for (const auto& job : started) {
+        startJob(job);
+    }
+}
+
+void JobQueue::startJob(const std::shared_ptr<Job>& job)
+{
+    emit jobStarted(job->id());
     
     // Create and start job runner
-    auto progressCallback = [this](const QString& id, int progress) {
-        QMetaObject::invokeMethod(this, [this, id, progress]() {
-            emit jobProgress(id, progress);
-            emit progressChanged(totalProgress());
-        }, Qt::QueuedConnection);
+    auto progressCallback = [this, job](JobId id, int progress) {
+        // A stopped job's progress was already removed from the totals
+        if (job->isCancelRequested()) return;
+        recordProgress(*job, progress);
+        m_progressBus->post(id, progress);
     };
     
-    auto finishedCallback = [this](const QString& id, bool success, const QString& error) {
+    auto finishedCallback = [this](JobId id, bool success, const QString& error) {
         QMetaObject::invokeMethod(this, [this, id, success, error]() {
             onJobFinished(id, success, error);
         }, Qt::QueuedConnection);
     };
     
-    auto* runner = new JobRunner(nextJob, progressCallback, finishedCallback);
+    auto* runner = new JobRunner(job, progressCallback, finishedCallback);
     m_threadPool->start(runner);
 }
 
-void JobQueue::onJobFinished(const QString& jobId, bool success, const QString& error)
+void JobQueue::onJobFinished(JobId jobId, bool success, const QString& error)
 {
     QMutexLocker locker(&m_mutex);
     
-    for (auto& job : m_jobs) {
-        if (job->id() == jobId) {
+    bool cancelled = false;
+    std::shared_ptr<Job> job = findJob(jobId);
+    if (job) {
+        JobStatus previous = job->status();
+        cancelled = !success && job->isCancelRequested();
+        
+        // Jobs cancelled by stopAll() keep their cancelled state
+        if (previous == JobStatus::Processing) {
+            // A borrowed slot goes back to the lane that lent it
+            m_runningCounts[m_borrowedSlots.take(jobId, laneFor(*job))]--;
+            m_runningJobs.removeOne(job);
+            m_cpuBudget.release(releasableThreads(*job));
+            endPreemption(jobId);
+            m_activeWeight -= CpuBudget::weightFor(job->type());
+            
             if (success) {
                 job->setStatus(JobStatus::Completed);
-                job->setProgress(100);
+                recordProgress(*job, 100);
+                m_totalOutputSize += job->outputSize();
+                m_totalTimeMs += job->processingTimeMs();
+                m_journal.recordCompleted(*job);
+            } else if (cancelled) {
+                job->setStatus(JobStatus::Cancelled);
+                m_progressSum -= job->retireProgress();
+                m_journal.recordCancelled(*job);
             } else {
                 job->setError(error);
+                m_progressSum -= job->retireProgress();
+                m_journal.recordFailed(*job);
             }
-            break;
+            updateStatusCounts(previous, job->status());
+            completeFollowers(job, success);
         }
     }
     
     locker.unlock();
     
+    // A late progress sample must not overwrite the final state in the GUI
+    m_progressBus->drop(jobId);
+    
     if (success) {
         emit jobCompleted(jobId);
+    } else if (cancelled) {
+        emit jobCancelled(jobId);
     } else {
         emit jobFailed(jobId, error);
     }
     
     emit progressChanged(totalProgress());
     
-    // Process next job
-    processNextJob();
+    // Refill the freed slot
+    dispatchJobs();
+}
+
+std::shared_ptr<Job> JobQueue::preemptionVictim() const
+{
+    // The lowest-priority batch encode that is still running
+    std::shared_ptr<Job> victim;
+    for (const auto& job : m_runningJobs) {
+        if (laneFor(*job) == ExpressLane || job->isPauseRequested()) continue;
+        if (!victim || job->priority() < victim->priority()) {
+            victim = job;
+        }
+    }
+    return victim;
+}
+
+void JobQueue::preemptFor(const std::shared_ptr<Job>& expressJob, const std::shared_ptr<Job>& victim)
+{
+    // The suspended encode's threads stay allocated to it and are lent to the express job
+    victim->requestPause();
+    m_preemptedBy.insert(expressJob->id(), victim);
+    m_lentThreads.insert(expressJob->id(), victim->threadBudget());
+    Logger::info(QString("Suspended %1 for express job %2")
+        .arg(victim->inputPath(), expressJob->inputPath()));
+}
+
+void JobQueue::endPreemption(JobId expressJobId)
+{
+    // A finishing victim simply drops out; a finishing express job frees its victim
+    for (auto it = m_preemptedBy.begin(); it != m_preemptedBy.end(); ) {
+        if (it.value()->id() == expressJobId) {
+            it = m_preemptedBy.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    std::shared_ptr<Job> victim = m_preemptedBy.take(expressJobId);
+    if (victim && victim->status() == JobStatus::Processing && !m_isPaused) {
+        victim->requestResume();
+    }
+}
+
+int JobQueue::releasableThreads(const Job& job)
+{
+    // An express job's lent threads go back to its victim, not to the budget; a victim
+    // that ends first leaves them with the express job, which then releases them
+    int threads = job.threadBudget() - m_lentThreads.take(job.id());
+    for (auto it = m_preemptedBy.constBegin(); it != m_preemptedBy.constEnd(); ++it) {
+        if (it.value()->id() == job.id()) {
+            threads -= m_lentThreads.take(it.key());
+        }
+    }
+    return qMax(0, threads);
+}
+
+void JobQueue::growGrants()
+{
+    // Threads freed by finished jobs would otherwise idle until the running encodes end;
+    // each picks its larger grant up at its next pass, wave or chunk
+    for (const auto& job : std::as_const(m_runningJobs)) {
+        if (m_cpuBudget.freeThreads() <= 0) break;
+        if (job->type() != JobType::Video || job->isPauseRequested()) continue;
+        
+        int extra = m_cpuBudget.grow(job->type(), job->threadBudget(), m_activeWeight);
+        if (extra > 0) {
+            job->setThreadBudget(job->threadBudget() + extra);
+        }
+    }
+}
+
+void JobQueue::findDuplicateInputs()
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (m_hashWatcher->isRunning()) return;
+    
+    // Only inputs sharing a size and batch profile with another input can share
+    // an output, so everything else skips hashing; express jobs never wait for it
+    QHash<QString, QList<std::shared_ptr<Job>>> bySize;
+    for (const auto& job : m_jobs) {
+        if (job->status() != JobStatus::Pending) continue;
+        if (job->priority() == JobPriority::Express || job->inputSize() <= 0) continue;
+        bySize[QString("%1|%2|%3").arg(job->inputSize()).arg(int(job->outputMediaFormat()))
+                   .arg(profileIdentity(*job))].append(job);
+    }
+    
+    QStringList paths;
+    for (const auto& group : bySize) {
+        if (group.size() < 2) continue;
+        for (const auto& job : group) {
+            m_awaitingHash.insert(job->id());
+            paths.append(job->inputPath());
+        }
+    }
+    if (paths.isEmpty()) return;
+    
+    locker.unlock();
+    
+    Logger::info(QString("Hashing %1 same-size input(s) to find duplicates").arg(paths.count()));
+    m_hashWatcher->setFuture(QtConcurrent::map(std::move(paths), [](const QString& path) {
+        ContentHasher::instance().hash(path);
+    }));
+}
+
+void JobQueue::completeFollowers(const std::shared_ptr<Job>& leader, bool success)
+{
+    QList<std::shared_ptr<Job>> followers = m_followers.take(leader->id());
+    if (followers.isEmpty()) return;
+    
+    if (!success) {
+        for (const auto& follower : followers) {
+            m_leaderOf.remove(follower->id());
+        }
+        promoteFollowers(followers);
+        return;
+    }
+    
+    // Followers stay in m_leaderOf, so nothing dispatches them while their output is
+    // shared; reflinked or hardlinked where the filesystem allows, copied otherwise
+    QString source = leader->outputPath();
+    qint64 outputSize = leader->outputSize();
+    QString checksum = leader->outputChecksum();
+    m_sharePool->start([this, followers, source, outputSize, checksum]() {
+        QList<QPair<std::shared_ptr<Job>, bool>> results;
+        for (const auto& follower : followers) {
+            bool shared = follower->status() == JobStatus::Pending &&
+                          FileUtils::linkOrCopy(source, follower->outputPath());
+            results.append(qMakePair(follower, shared));
+        }
+        QMetaObject::invokeMethod(this, [this, results, outputSize, checksum]() {
+            onFollowersShared(results, outputSize, checksum);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void JobQueue::onFollowersShared(const QList<QPair<std::shared_ptr<Job>, bool>>& results,
+                                 qint64 outputSize, const QString& checksum)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QList<JobId> completed;
+    QList<std::shared_ptr<Job>> unshared;
+    for (const auto& result : results) {
+        const auto& follower = result.first;
+        m_leaderOf.remove(follower->id());
+        
+        // Cleared or stopped while its output was being shared
+        if (!m_jobIndex.contains(follower->id()) || follower->status() != JobStatus::Pending) {
+            continue;
+        }
+        
+        if (!result.second) {
+            unshared.append(follower);
+            continue;
+        }
+        
+        follower->setOutputSize(outputSize);
+        follower->setOutputChecksum(checksum);
+        follower->setStatus(JobStatus::Completed);
+        updateStatusCounts(JobStatus::Pending, JobStatus::Completed);
+        recordProgress(*follower, 100);
+        m_totalOutputSize += outputSize;
+        m_journal.recordCompleted(*follower);
+        completed.append(follower->id());
+    }
+    promoteFollowers(unshared);
+    
+    locker.unlock();
+    
+    for (JobId followerId : completed) {
+        emit jobCompleted(followerId);
+    }
+    emit progressChanged(totalProgress());
+    
+    // Also reports the end of the batch when these were the last jobs
+    dispatchJobs();
+}
+
+void JobQueue::promoteFollowers(const QList<std::shared_ptr<Job>>& followers)
+{
+    // The leader produced nothing to share; the next copy is encoded itself
+    std::shared_ptr<Job> newLeader;
+    for (const auto& follower : followers) {
+        if (follower->status() != JobStatus::Pending) continue;
+        
+        if (!newLeader) {
+            newLeader = follower;
+            enqueueReady(follower);
+        } else {
+            m_followers[newLeader->id()].append(follower);
+            m_leaderOf.insert(follower->id(), newLeader->id());
+        }
+    }
+}
+
+void JobQueue::releaseFollowers()
+{
+    // Followers go back to the ready queues and are regrouped on the next start
+    for (const auto& followers : m_followers) {
+        for (const auto& follower : followers) {
+            if (follower->status() == JobStatus::Pending) {
+                enqueueReady(follower);
+            }
+        }
+    }
+    m_followers.clear();
+    m_leaderOf.clear();
+    
+    for (auto& entry : m_heldEntries) {
+        if (entry.job->status() == JobStatus::Pending) {
+            m_readyQueues[laneFor(*entry.job)].push(std::move(entry));
+        }
+    }
+    m_heldEntries.clear();
+    m_awaitingHash.clear();
+}
+
+void JobQueue::onVideoCostsProbed()
+{
+    QMutexLocker locker(&m_mutex);
+    m_probingVideos = false;
+    rebuildReadyQueue(VideoLane);
+    locker.unlock();
+    
+    dispatchJobs();
+}
+
+void JobQueue::onInputsHashed()
+{
+    QMutexLocker locker(&m_mutex);
+    
+    // The earliest-added copy of each input leads; later copies follow it
+    QHash<QString, std::shared_ptr<Job>> leaders;
+    int duplicates = 0;
+    for (const auto& job : m_jobs) {
+        if (!m_awaitingHash.contains(job->id())) continue;
+        if (job->status() != JobStatus::Pending) continue;
+        
+        // Cached by the parallel pass, so this is only a stat per file
+        QString digest = ContentHasher::instance().hash(job->inputPath());
+        if (digest.isEmpty()) continue;
+        
+        // Same bytes encoded with other settings is not a duplicate
+        QString key = QString("%1|%2|%3").arg(digest, job->outputFormat())
+                          .arg(profileIdentity(*job));
+        auto leader = leaders.constFind(key);
+        if (leader == leaders.constEnd()) {
+            leaders.insert(key, job);
+        } else {
+            m_followers[leader.value()->id()].append(job);
+            m_leaderOf.insert(job->id(), leader.value()->id());
+            duplicates++;
+        }
+    }
+    m_awaitingHash.clear();
+    
+    // Return held jobs to their lanes, minus the followers
+    for (auto& entry : m_heldEntries) {
+        if (entry.job->status() != JobStatus::Pending) continue;
+        if (m_leaderOf.contains(entry.job->id())) continue;
+        entry.priority = static_cast<int>(entry.job->priority());
+        entry.key = sortKey(*entry.job);
+        m_readyQueues[laneFor(*entry.job)].push(std::move(entry));
+    }
+    m_heldEntries.clear();
+    
+    locker.unlock();
+    
+    ContentHasher::instance().save();
+    if (duplicates > 0) {
+        Logger::info(QString("Found %1 duplicate input(s); each is encoded once").arg(duplicates));
+    }
+    
+    dispatchJobs();
+}
+
+std::shared_ptr<Job> JobQueue::findJob(JobId jobId) const
+{
+    auto it = m_jobIndex.constFind(jobId);
+    return it != m_jobIndex.constEnd() ? m_jobs[it.value()] : nullptr;
+}
+
+quintptr JobQueue::profileIdentity(const Job& job)
+{
+    // Each batch snapshots one EncodeProfile, kept alive by its jobs
+    return reinterpret_cast<quintptr>(&job.profile());
+}
+
+double JobQueue::estimateCost(const Job& job, const VideoInfo* info)
+{
+    // A dry run with this batch's settings measured the file directly
+    SampleEstimate sample;
+    if (SampleEstimator::instance().lookup(job.inputPath(), job.profile(), sample)) {
+        return sample.coreSeconds;
+    }
+    
+    // Then the model fitted to past jobs with the same profile. The content class is only
+    // known once the encode analyses the file, so untuned camera footage is assumed; the
+    // CRF is only known up front in custom mode, the other modes each fix their own
+    double work = workUnits(job, info);
+    double coreSeconds = 0;
+    int crf = -1;
+    QString contentClass;
+    if (job.type() == JobType::Video) {
+        crf = job.profile().videoCompressionMode == "custom" ? job.profile().videoCrf : -1;
+        contentClass = "camera";
+    }
+    if (ThroughputHistory::instance().predict(ThroughputHistory::profileKey(job), work, coreSeconds,
+                                              crf, contentClass)) {
+        return coreSeconds;
+    }
+    
+    return work / (job.type() == JobType::Video ? NominalPixelsPerCoreSecond
+                                                : NominalImageBytesPerCoreSecond);
+}
+
+JobQueue::Lane JobQueue::laneFor(const Job& job)
+{
+    if (job.priority() == JobPriority::Express) return ExpressLane;
+    
+    // Unknown types fail immediately, so they ride in the cheap image lane
+    return job.type() == JobType::Video ? VideoLane : ImageLane;
+}
+
+void JobQueue::enqueueReady(const std::shared_ptr<Job>& job)
+{
+    m_readyQueues[laneFor(*job)].push({static_cast<int>(job->priority()), sortKey(*job),
+                                       m_nextSequence++, job});
+}
+
+std::shared_ptr<Job> JobQueue::takeNextReady(Lane lane)
+{
+    ReadyQueue& queue = m_readyQueues[lane];
+    while (!queue.empty()) {
+        ReadyEntry entry = queue.top();
+        queue.pop();
+        
+        // Skip entries whose job was cancelled while queued
+        if (entry.job->status() != JobStatus::Pending) continue;
+        
+        // Duplicates wait for their leader's output instead of encoding
+        if (m_leaderOf.contains(entry.job->id())) continue;
+        
+        // Possible duplicates are parked until hashing decides
+        if (m_awaitingHash.contains(entry.job->id())) {
+            m_heldEntries.push_back(std::move(entry));
+            continue;
+        }
+        
+        return entry.job;
+    }
+    return nullptr;
+}
+
+bool JobQueue::hasReadyJob(Lane lane)
+{
+    // Videos held back for probing still count as work for their lane
+    if (lane == VideoLane && m_probingVideos) return true;
+    
+    ReadyQueue& queue = m_readyQueues[lane];
+    while (!queue.empty()) {
+        const ReadyEntry& entry = queue.top();
+        if (entry.job->status() == JobStatus::Pending && !m_leaderOf.contains(entry.job->id())) {
+            return true;
+        }
+        queue.pop();
+    }
+    return false;
+}
+
+JobQueue::Lane JobQueue::lendingLane(Lane lane)
+{
+    // Express jobs have their own slots and preemption
+    if (lane == ExpressLane) return LaneCount;
+    
+    Lane other = lane == ImageLane ? VideoLane : ImageLane;
+    if (m_runningCounts[other] >= m_laneBudgets[other] || hasReadyJob(other)) {
+        return LaneCount;
+    }
+    return other;
+}
+
+double JobQueue::sortKey(const Job& job) const
+{
+    switch (m_policy) {
+        case SchedulingPolicy::LongestFirst:
+            return -job.costEstimate();
+        case SchedulingPolicy::ShortestFirst:
+            return job.costEstimate();
+        case SchedulingPolicy::Fifo:
+            break;
+    }
+    return 0;
+}
+
+void JobQueue::rebuildReadyQueue(Lane lane)
+{
+    ReadyQueue& queue = m_readyQueues[lane];
+    
+    std::vector<ReadyEntry> entries;
+    entries.reserve(queue.size());
+    while (!queue.empty()) {
+        entries.push_back(queue.top());
+        queue.pop();
+    }
+    
+    // Re-key live entries, dropping cancelled or re-laned ones;
+    // sequence numbers keep FIFO ties stable
+    for (auto& entry : entries) {
+        if (entry.job->status() != JobStatus::Pending) continue;
+        if (laneFor(*entry.job) != lane) continue;
+        entry.priority = static_cast<int>(entry.job->priority());
+        entry.key = sortKey(*entry.job);
+        queue.push(std::move(entry));
+    }
+}
+
+void JobQueue::probeVideoCosts()
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (m_probingVideos) return;
+    
+    QList<std::shared_ptr<Job>> videos;
+    for (const auto& job : m_jobs) {
+        if (job->type() == JobType::Video && job->status() == JobStatus::Pending) {
+            videos.append(job);
+        }
+    }
+    if (videos.isEmpty()) return;
+    
+    m_probingVideos = true;
+    locker.unlock();
+    
+    // ffprobe runs in parallel off the GUI thread; results are cached by MediaInfo
+    m_probeWatcher->setFuture(QtConcurrent::map(std::move(videos),
+        [](std::shared_ptr<Job>& job) {
+            VideoInfo info = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath);
+            job->setCostEstimate(estimateCost(*job, &info));
+        }));
+}
+
+void JobQueue::updateStatusCounts(JobStatus from, JobStatus to)
+{
+    m_statusCounts[static_cast<int>(from)]--;
+    m_statusCounts[static_cast<int>(to)]++;
+}
+
+void JobQueue::resetCounters()
+{
+    for (auto& count : m_statusCounts) {
+        count.store(0);
+    }
+    m_totalJobs.store(0);
+    m_totalInputSize.store(0);
+    m_totalOutputSize.store(0);
+    m_totalTimeMs.store(0);
+    m_progressSum.store(0);
+}
+
+int JobQueue::statusCount(JobStatus status) const
+{
+    return m_statusCounts[static_cast<int>(status)].load(std::memory_order_relaxed);
+}
+
+void JobQueue::recordProgress(Job& job, int progress)
+{
+    // Apply only the delta so the running sum never needs a rescan; a stopped or
+    // failed job's progress is retired, so a late report changes nothing
+    int previous = 0;
+    if (job.advanceProgress(progress, previous)) {
+        m_progressSum.fetch_add(qBound(0, progress, 100) - previous, std::memory_order_relaxed);
+    }
 }
@@ -8,13 +8,25 @@
 
 #include <QObject>
 #include <QList>
+#include <QPair>
+#include <QHash>
+#include <QSet>
 #include <QMutex>
 #include <QThreadPool>
+#include <QFutureWatcher>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <queue>
+#include <vector>
 
 #include "Job.h"
+#include "CpuBudget.h"
+#include "ProgressBus.h"
+#include "JobJournal.h"
 
 class Settings;
+struct VideoInfo;
 
 struct JobStatistics {
     int total = 0;
@@ -27,6 +39,12 @@ struct JobStatistics {
     qint64 totalTimeMs = 0;
 };
 
+enum class SchedulingPolicy {
+    Fifo,
+    LongestFirst,
+    ShortestFirst
+};
+
 class JobQueue : public QObject
 {
     Q_OBJECT
@@ -35,49 +53,202 @@ public:
     explicit JobQueue(QObject *parent = nullptr);
     ~JobQueue();
 
-    void addJob(const QString& filePath, const Settings& settings);
-    void addJobs(const QStringList& filePaths, const Settings& settings);
+    // Jobs share one EncodeProfile per batch; the Settings overloads snapshot it
+    void addJob(const QString& filePath, EncodeProfilePtr profile,
+                JobPriority priority = JobPriority::Normal);
+    void addJob(const QString& filePath, const Settings& settings,
+                JobPriority priority = JobPriority::Normal);
+    void addJobs(const QStringList& filePaths, const Settings& settings,
+                 JobPriority priority = JobPriority::Normal);
+    
+    // Bulk ingest: files are stat'ed and classified in parallel, inserted under
+    // one lock and announced by a single jobsAdded()
+    void addJobs(const QStringList& filePaths, EncodeProfilePtr profile,
+                 JobPriority priority = JobPriority::Normal);
+    
+    // Reprioritises a pending job; running jobs keep their slot and return false
+    bool setJobPriority(JobId jobId, JobPriority priority);
     
     void start();
     void pause();
     void resume();
     void stopAll();
-    void cancel(const QString& jobId);
+    void cancel(JobId jobId);
+    
+    void setSchedulingPolicy(SchedulingPolicy policy);
+    SchedulingPolicy schedulingPolicy() const;
+    static SchedulingPolicy policyFromString(const QString& name);
     
     bool isPaused() const { return m_isPaused; }
     bool isProcessing() const { return m_isProcessing; }
     
+    // Lock-free; backed by counters maintained on every transition
     int totalProgress() const;
+    
+    // Wall-clock seconds left for unfinished jobs, from their cost estimates spread over
+    // the CPU budget; walks the job list, so callers should not poll it per frame
+    double estimatedRemainingSeconds() const;
+    
+    // Wall-clock seconds left for one running job, blending its cost model with the
+    // pace it has shown so far; -1 when the job is not running
+    double estimatedRemainingSeconds(JobId jobId) const;
     JobStatistics statistics() const;
     
-    Job* getJob(const QString& jobId) const;
+    Job* getJob(JobId jobId) const;
     QList<Job*> allJobs() const;
+    QList<Job*> jobs(int first, int count) const;
     int jobCount() const;
     
     void clear();
+    
+    // Files of a batch interrupted by a crash or exit, from the on-disk journal
+    QStringList resumableFiles() const;
+    void discardResumableBatch();
 
 signals:
-    void jobAdded(const QString& jobId);
-    void jobStarted(const QString& jobId);
-    void jobProgress(const QString& jobId, int progress);
-    void jobCompleted(const QString& jobId);
-    void jobFailed(const QString& jobId, const QString& error);
+    void jobAdded(JobId jobId);
+    void jobsAdded(int first, int count);
+    void jobStarted(JobId jobId);
+    void jobsProgressed(const QVector<JobProgressUpdate>& updates);
+    void jobCompleted(JobId jobId);
+    void jobFailed(JobId jobId, const QString& error);
+    void jobCancelled(JobId jobId);
     void allJobsCompleted();
     void progressChanged(int totalProgress);
 
 private:
-    void processNextJob();
-    void onJobFinished(const QString& jobId, bool success, const QString& error);
+    // Ready queue entry; highest priority first, then the smallest key,
+    // ties in insertion order
+    struct ReadyEntry {
+        int priority = 0;
+        double key = 0;
+        quint64 sequence = 0;
+        std::shared_ptr<Job> job;
+    };
+
+    struct ReadyOrder {
+        bool operator()(const ReadyEntry& a, const ReadyEntry& b) const {
+            if (a.priority != b.priority) return a.priority < b.priority;
+            if (a.key != b.key) return a.key > b.key;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    using ReadyQueue = std::priority_queue<ReadyEntry, std::vector<ReadyEntry>, ReadyOrder>;
+
+    // Each lane has its own ready queue and concurrency budget
+    enum Lane {
+        ImageLane = 0,
+        VideoLane,
+        ExpressLane,
+        LaneCount
+    };
+
+    void dispatchJobs();
+    void startJob(const std::shared_ptr<Job>& job);
+    void onJobFinished(JobId jobId, bool success, const QString& error);
+    void onVideoCostsProbed();
+    void onInputsHashed();
+    
+    static double estimateCost(const Job& job, const VideoInfo* info = nullptr);
+    
+    // Must be called with m_mutex held
+    double remainingCoreSeconds(const Job& job) const;
+    
+    // Rough throughput for files with neither a dry run nor throughput history
+    static constexpr double NominalPixelsPerCoreSecond = 3.0e6;
+    static constexpr double NominalImageBytesPerCoreSecond = 8.0e6;
+
+    // Checksums of outputs the journal says earlier runs finished, for insertJob()
+    QHash<JobId, QString> completedOutputChecksums(const QList<std::shared_ptr<Job>>& jobs);
+    
+    // Must be called with m_mutex held
+    bool insertJob(const std::shared_ptr<Job>& job, const QString& outputChecksum);
+    std::shared_ptr<Job> findJob(JobId jobId) const;
+    static Lane laneFor(const Job& job);
+    void enqueueReady(const std::shared_ptr<Job>& job);
+    std::shared_ptr<Job> takeNextReady(Lane lane);
+    
+    // Drops stale entries off the top; false when the lane has nothing to dispatch
+    bool hasReadyJob(Lane lane);
+    
+    // The other batch lane when it has a free slot and nothing of its own to run,
+    // LaneCount otherwise
+    Lane lendingLane(Lane lane);
+    double sortKey(const Job& job) const;
+    void rebuildReadyQueue(Lane lane);
+    void probeVideoCosts();
+    std::shared_ptr<Job> preemptionVictim() const;
+    void preemptFor(const std::shared_ptr<Job>& expressJob, const std::shared_ptr<Job>& victim);
+    void endPreemption(JobId expressJobId);
+    int releasableThreads(const Job& job);
+    void growGrants();
+    void findDuplicateInputs();
+    static quintptr profileIdentity(const Job& job);
+    void completeFollowers(const std::shared_ptr<Job>& leader, bool success);
+    void onFollowersShared(const QList<QPair<std::shared_ptr<Job>, bool>>& results,
+                           qint64 outputSize, const QString& checksum);
+    void promoteFollowers(const QList<std::shared_ptr<Job>>& followers);
+    void releaseFollowers();
+    void updateStatusCounts(JobStatus from, JobStatus to);
+    void resetCounters();
+    
+    // Safe from any thread
+    int statusCount(JobStatus status) const;
+    void recordProgress(Job& job, int progress);
 
 private:
+    // m_jobs owns every job; the index maps ids to positions in it, which stay put
+    // because jobs only leave the queue all at once
     QList<std::shared_ptr<Job>> m_jobs;
+    QHash<JobId, qsizetype> m_jobIndex;
+    std::array<ReadyQueue, LaneCount> m_readyQueues;
+    std::array<int, LaneCount> m_runningCounts{};
+    std::array<int, LaneCount> m_laneBudgets{};
+    
+    // Jobs running in a slot borrowed from another lane, and that lane
+    QHash<JobId, Lane> m_borrowedSlots;
+    QList<std::shared_ptr<Job>> m_runningJobs;
+    
+    // Batch encodes suspended on behalf of a running express job, and the threads
+    // each express job runs on that its victim still holds
+    bool m_preemptForExpress = false;
+    QHash<JobId, std::shared_ptr<Job>> m_preemptedBy;
+    QHash<JobId, int> m_lentThreads;
+    
+    CpuBudget m_cpuBudget;
+    int m_activeWeight = 0;
+    
+    SchedulingPolicy m_policy = SchedulingPolicy::Fifo;
+    QFutureWatcher<void>* m_probeWatcher = nullptr;
+    bool m_probingVideos = false;
+    
+    // Byte-identical inputs: one leader is encoded, its followers reuse the output
+    QFutureWatcher<void>* m_hashWatcher = nullptr;
+    QSet<JobId> m_awaitingHash;
+    std::vector<ReadyEntry> m_heldEntries;
+    QHash<JobId, QList<std::shared_ptr<Job>>> m_followers;
+    QHash<JobId, JobId> m_leaderOf;
+    
+    // Aggregates read without taking m_mutex
+    std::array<std::atomic<int>, 6> m_statusCounts{};
+    std::atomic<int> m_totalJobs{0};
+    std::atomic<qint64> m_totalInputSize{0};
+    std::atomic<qint64> m_totalOutputSize{0};
+    std::atomic<qint64> m_totalTimeMs{0};
+    std::atomic<qint64> m_progressSum{0};
+    
+    quint64 m_nextSequence = 0;
+
+    JobJournal m_journal;
+
     QThreadPool* m_threadPool = nullptr;
+    QThreadPool* m_sharePool = nullptr;
+    ProgressBus* m_progressBus = nullptr;
     mutable QMutex m_mutex;
     
     bool m_isProcessing = false;
     bool m_isPaused = false;
-    int m_currentJobIndex = 0;
-    int m_maxConcurrentJobs = 4;
 };
 
 #endif // JOBQUEUE_H
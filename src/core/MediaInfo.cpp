@@ -4,9 +4,17 @@
  */
 
 #include "MediaInfo.h"
+
 #include <QFileInfo>
 #include <QImageReader>
 #include <QProcess>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 
 ImageInfo MediaInfo::getImageInfo(const QString& filePath)
 {
@@ -30,16 +38,48 @@ ImageInfo MediaInfo::getImageInfo(const QString& filePath)
     return info;
 }
 
-VideoInfo MediaInfo::getVideoInfo(const QString& filePath)
+VideoInfo MediaInfo::getVideoInfo(const QString& filePath, const QString& ffmpegPath)
+{
+    struct CacheEntry {
+        qint64 size = 0;
+        qint64 modified = 0;
+        VideoInfo info;
+    };
+    static QMutex cacheMutex;
+    static QHash<QString, CacheEntry> cache;
+    
+    QFileInfo fileInfo(filePath);
+    qint64 size = fileInfo.size();
+    qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto it = cache.constFind(filePath);
+        if (it != cache.constEnd() && it->size == size && it->modified == modified) {
+            return it->info;
+        }
+    }
+    
+    VideoInfo info = probeVideo(filePath, ffmpegPath);
+    
+    // Bounded for long sessions; an evicted file is simply probed again
+    QMutexLocker locker(&cacheMutex);
+    if (cache.size() >= MaxCachedProbes && !cache.contains(filePath)) {
+        cache.erase(cache.begin());
+    }
+    cache.insert(filePath, {size, modified, info});
+    return info;
+}
+
+VideoInfo MediaInfo::probeVideo(const QString& filePath, const QString& ffmpegPath)
 {
     VideoInfo info;
     QFileInfo fileInfo(filePath);
     info.fileSize = fileInfo.size();
     info.container = fileInfo.suffix().toUpper();
     
-    // Use ffprobe if available
     QProcess process;
-    process.start("ffprobe", {
+    process.start(ffprobePath(ffmpegPath), {
         "-v", "quiet",
         "-print_format", "json",
         "-show_format",
@@ -47,15 +87,68 @@ VideoInfo MediaInfo::getVideoInfo(const QString& filePath)
         filePath
     });
     
-    if (process.waitForFinished(5000)) {
-        // Parse JSON output (simplified)
-        QString output = process.readAllStandardOutput();
-        // TODO: Parse JSON to extract video info
+    if (!process.waitForFinished(5000) || process.exitCode() != 0) {
+        return info;
+    }
+    
+    QJsonObject root = QJsonDocument::fromJson(process.readAllStandardOutput()).object();
+    
+    QJsonObject format = root.value("format").toObject();
+    info.duration = format.value("duration").toString().toDouble();
+    info.bitrate = format.value("bit_rate").toString().toLongLong();
+    
+    const QJsonArray streams = root.value("streams").toArray();
+    for (const QJsonValue& value : streams) {
+        QJsonObject stream = value.toObject();
+        QString codecType = stream.value("codec_type").toString();
+        
+        if (codecType == "video" && info.videoCodec.isEmpty()) {
+            info.videoCodec = stream.value("codec_name").toString();
+            info.pixelFormat = stream.value("pix_fmt").toString();
+            info.videoBitrate = stream.value("bit_rate").toString().toLongLong();
+            info.width = stream.value("width").toInt();
+            info.height = stream.value("height").toInt();
+            
+            // Frame rate comes as a rational, e.g. "30000/1001"
+            QStringList rate = stream.value("avg_frame_rate").toString().split('/');
+            if (rate.size() == 2 && rate[1].toDouble() > 0) {
+                info.fps = rate[0].toDouble() / rate[1].toDouble();
+            }
+        } else if (codecType == "audio" && info.audioCodec.isEmpty()) {
+            info.audioCodec = stream.value("codec_name").toString();
+            info.audioChannels = stream.value("channels").toInt();
+            info.audioSampleRate = stream.value("sample_rate").toString().toInt();
+            info.audioBitrate = stream.value("bit_rate").toString().toLongLong();
+        }
     }
     
     return info;
 }
 
+QString MediaInfo::ffprobePath(const QString& ffmpegPath)
+{
+#ifdef Q_OS_WIN
+    const QString exeName = "ffprobe.exe";
+#else
+    const QString exeName = "ffprobe";
+#endif
+    
+    // Prefer the ffprobe that ships next to the configured ffmpeg
+    if (!ffmpegPath.isEmpty() && QFileInfo::exists(ffmpegPath)) {
+        QString sibling = QFileInfo(ffmpegPath).absolutePath() + "/" + exeName;
+        if (QFileInfo::exists(sibling)) {
+            return sibling;
+        }
+    }
+    
+    QString bundled = QCoreApplication::applicationDirPath() + "/ffmpeg/bin/" + exeName;
+    if (QFileInfo::exists(bundled)) {
+        return bundled;
+    }
+    
+    return "ffprobe";  // Use system PATH
+}
+
 bool MediaInfo::isImage(const QString& filePath)
 {
     static const QStringList exts = {
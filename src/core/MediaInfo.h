@@ -26,8 +26,11 @@ struct VideoInfo {
     int height = 0;
     double fps = 0;
     double duration = 0;  // seconds
-    int64_t bitrate = 0;
+    int64_t bitrate = 0;        // whole file
+    int64_t videoBitrate = 0;   // 0 when the container does not record it
+    int64_t audioBitrate = 0;
     QString videoCodec;
+    QString pixelFormat;
     QString audioCodec;
     QString container;
     int audioChannels = 0;
@@ -39,9 +42,19 @@ class MediaInfo
 {
 public:
     static ImageInfo getImageInfo(const QString& filePath);
-    static VideoInfo getVideoInfo(const QString& filePath);
+    
+    // Probed once per file; later calls are served from a cache keyed by size and mtime.
+    // Safe on worker threads: ffprobe is found next to the profile's ffmpeg, not from Settings
+    static VideoInfo getVideoInfo(const QString& filePath, const QString& ffmpegPath);
     static bool isImage(const QString& filePath);
     static bool isVideo(const QString& filePath);
+    
+    static QString ffprobePath(const QString& ffmpegPath);
+
+private:
+    static VideoInfo probeVideo(const QString& filePath, const QString& ffmpegPath);
+    
+    static constexpr int MaxCachedProbes = 4096;
 };
 
 #endif // MEDIAINFO_H
@@ -0,0 +1,63 @@
+/**
+ * @file PathPool.cpp
+ * @brief Directory interning and file name arena implementation
+ */
+
+#include "PathPool.h"
+
+PathPool& PathPool::instance()
+{
+    static PathPool instance;
+    return instance;
+}
+
+quint32 PathPool::intern(const QString& dir)
+{
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_index.constFind(dir);
+        if (it != m_index.constEnd()) return it.value();
+    }
+    
+    QWriteLocker locker(&m_lock);
+    auto it = m_index.constFind(dir);
+    if (it != m_index.constEnd()) return it.value();
+    
+    quint32 index = static_cast<quint32>(m_dirs.size());
+    m_dirs.push_back(dir);
+    m_index.insert(dir, index);
+    return index;
+}
+
+QString PathPool::at(quint32 index) const
+{
+    QReadLocker locker(&m_lock);
+    return index < m_dirs.size() ? m_dirs[index] : QString();
+}
+
+int PathPool::size() const
+{
+    QReadLocker locker(&m_lock);
+    return static_cast<int>(m_dirs.size());
+}
+
+quint32 PathPool::appendName(const QString& name)
+{
+    // No file system allows names anywhere near 65535 units
+    qsizetype length = qMin<qsizetype>(name.size(), 0xFFFF);
+    
+    QWriteLocker locker(&m_lock);
+    quint32 offset = static_cast<quint32>(m_names.size());
+    m_names.push_back(static_cast<char16_t>(length));
+    m_names.insert(m_names.end(), name.utf16(), name.utf16() + length);
+    return offset;
+}
+
+QString PathPool::nameAt(quint32 offset) const
+{
+    QReadLocker locker(&m_lock);
+    if (offset >= m_names.size()) return QString();
+    
+    qsizetype length = m_names[offset];
+    return QString(reinterpret_cast<const QChar*>(m_names.data() + offset + 1), length);
+}
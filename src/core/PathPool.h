@@ -0,0 +1,44 @@
+/**
+ * @file PathPool.h
+ * @brief Interned directory strings and packed file names shared by all jobs
+ */
+
+#ifndef PATHPOOL_H
+#define PATHPOOL_H
+
+#include <QString>
+#include <QHash>
+#include <QReadWriteLock>
+#include <vector>
+
+class PathPool
+{
+public:
+    static PathPool& instance();
+
+    // Returns a stable index for dir; equal strings share one entry
+    quint32 intern(const QString& dir);
+    QString at(quint32 index) const;
+    
+    int size() const;
+    
+    // File names are nearly all distinct, so they are not interned but packed
+    // back to back into one arena; returns the name's offset in it
+    quint32 appendName(const QString& name);
+    QString nameAt(quint32 offset) const;
+
+private:
+    PathPool() = default;
+    ~PathPool() = default;
+    PathPool(const PathPool&) = delete;
+    PathPool& operator=(const PathPool&) = delete;
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_index;
+    std::vector<QString> m_dirs;
+    
+    // Each name is a length unit followed by its UTF-16 units
+    std::vector<char16_t> m_names;
+};
+
+#endif // PATHPOOL_H
@@ -0,0 +1,66 @@
+/**
+ * @file ProgressBus.cpp
+ * @brief Coalescing progress channel implementation
+ */
+
+#include "ProgressBus.h"
+
+#include <QTimer>
+
+ProgressBus::ProgressBus(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::CoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ProgressBus::flush);
+    setPublishRate(30);
+}
+
+void ProgressBus::setPublishRate(int hz)
+{
+    m_timer->setInterval(1000 / qBound(1, hz, 120));
+}
+
+void ProgressBus::start()
+{
+    m_timer->start();
+}
+
+void ProgressBus::stop()
+{
+    m_timer->stop();
+    
+    // Final states are delivered by the queue's own signals
+    QMutexLocker locker(&m_mutex);
+    m_latest.clear();
+}
+
+void ProgressBus::post(JobId jobId, int progress)
+{
+    QMutexLocker locker(&m_mutex);
+    m_latest.insert(jobId, progress);
+}
+
+void ProgressBus::drop(JobId jobId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_latest.remove(jobId);
+}
+
+void ProgressBus::flush()
+{
+    QHash<JobId, int> latest;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_latest.isEmpty()) return;
+        latest.swap(m_latest);
+    }
+    
+    QVector<JobProgressUpdate> updates;
+    updates.reserve(latest.size());
+    for (auto it = latest.constBegin(); it != latest.constEnd(); ++it) {
+        updates.append({it.key(), it.value()});
+    }
+    
+    emit jobsProgressed(updates);
+}
@@ -0,0 +1,50 @@
+/**
+ * @file ProgressBus.h
+ * @brief Coalescing progress channel between worker threads and the GUI
+ */
+
+#ifndef PROGRESSBUS_H
+#define PROGRESSBUS_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "Job.h"
+
+class QTimer;
+
+struct JobProgressUpdate {
+    JobId jobId = 0;
+    int progress = 0;
+};
+
+class ProgressBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProgressBus(QObject *parent = nullptr);
+    ~ProgressBus() = default;
+
+    void setPublishRate(int hz);
+    void start();
+    void stop();
+
+    // Called from worker threads; only the latest value per job is kept
+    void post(JobId jobId, int progress);
+    void drop(JobId jobId);
+    
+    void flush();
+
+signals:
+    void jobsProgressed(const QVector<JobProgressUpdate>& updates);
+
+private:
+    QTimer* m_timer = nullptr;
+    QMutex m_mutex;
+    QHash<JobId, int> m_latest;
+};
+
+#endif // PROGRESSBUS_H
@@ -37,6 +37,11 @@ void Settings::resetToDefaults()
     setOverwriteOriginal(false);
     setRecursiveScan(true);
     setThreadCount(QThread::idealThreadCount());
+    setMaxVideoJobs(2);
+    setMaxImageJobs(qMax(1, QThread::idealThreadCount() - 2));
+    setSchedulingPolicy("fifo");
+    setExpressSlots(1);
+    setPreemptForExpress(false);
     setTheme("dark");
     setShowNotifications(true);
     setPlaySounds(true);
@@ -54,7 +59,18 @@ void Settings::resetToDefaults()
     setVideoCodec("av1");
     setVideoCompressionMode("visually_lossless");
     setVideoCrf(18);
+    setVideoQualityMetric("vmaf");
+    setVideoTargetQuality(93.0);
     setVideoPreset("medium");
+    setChunkedEncode(false);
+    setVideoChunkCount(0);
+    setSmartStreamCopy(true);
+    setContentTuning(true);
+    setAv1Preset(-1);
+    setAv1TileColumns(-1);
+    setAv1TileRows(-1);
+    setAv1Lookahead(-1);
+    setAv1MaxThreads(0);
     setPreserveAudio(true);
     setAudioCodec("opus");
     setAudioBitrate(192);
@@ -67,6 +83,7 @@ void Settings::resetToDefaults()
     
     setFfmpegPath("");
     setVipsPath("");
+    setInProcessVideo(true);
     
     save();
 }
@@ -122,6 +139,58 @@ void Settings::setThreadCount(int count)
     m_settings.setValue("general/threadCount", count);
 }
 
+int Settings::maxVideoJobs() const
+{
+    return m_settings.value("general/maxVideoJobs", 2).toInt();
+}
+
+void Settings::setMaxVideoJobs(int count)
+{
+    m_settings.setValue("general/maxVideoJobs", count);
+}
+
+int Settings::maxImageJobs() const
+{
+    // Default: whatever the video encodes leave of the thread budget
+    return m_settings.value("general/maxImageJobs", 
+        qMax(1, threadCount() - maxVideoJobs())).toInt();
+}
+
+void Settings::setMaxImageJobs(int count)
+{
+    m_settings.setValue("general/maxImageJobs", count);
+}
+
+QString Settings::schedulingPolicy() const
+{
+    return m_settings.value("general/schedulingPolicy", "fifo").toString();
+}
+
+void Settings::setSchedulingPolicy(const QString& policy)
+{
+    m_settings.setValue("general/schedulingPolicy", policy);
+}
+
+int Settings::expressSlots() const
+{
+    return m_settings.value("general/expressSlots", 1).toInt();
+}
+
+void Settings::setExpressSlots(int count)
+{
+    m_settings.setValue("general/expressSlots", count);
+}
+
+bool Settings::preemptForExpress() const
+{
+    return m_settings.value("general/preemptForExpress", false).toBool();
+}
+
+void Settings::setPreemptForExpress(bool preempt)
+{
+    m_settings.setValue("general/preemptForExpress", preempt);
+}
+
 QString Settings::theme() const
 {
     return m_settings.value("general/theme", "dark").toString();
@@ -274,6 +343,26 @@ void Settings::setVideoCrf(int crf)
     m_settings.setValue("video/crf", crf);
 }
 
+QString Settings::videoQualityMetric() const
+{
+    return m_settings.value("video/qualityMetric", "vmaf").toString();
+}
+
+void Settings::setVideoQualityMetric(const QString& metric)
+{
+    m_settings.setValue("video/qualityMetric", metric);
+}
+
+double Settings::videoTargetQuality() const
+{
+    return m_settings.value("video/targetQuality", 93.0).toDouble();
+}
+
+void Settings::setVideoTargetQuality(double target)
+{
+    m_settings.setValue("video/targetQuality", target);
+}
+
 QString Settings::videoPreset() const
 {
     return m_settings.value("video/preset", "medium").toString();
@@ -284,6 +373,96 @@ void Settings::setVideoPreset(const QString& preset)
     m_settings.setValue("video/preset", preset);
 }
 
+bool Settings::chunkedEncode() const
+{
+    return m_settings.value("video/chunkedEncode", false).toBool();
+}
+
+void Settings::setChunkedEncode(bool enabled)
+{
+    m_settings.setValue("video/chunkedEncode", enabled);
+}
+
+int Settings::videoChunkCount() const
+{
+    return m_settings.value("video/chunkCount", 0).toInt();
+}
+
+void Settings::setVideoChunkCount(int count)
+{
+    m_settings.setValue("video/chunkCount", qMax(0, count));
+}
+
+bool Settings::smartStreamCopy() const
+{
+    return m_settings.value("video/smartCopy", true).toBool();
+}
+
+void Settings::setSmartStreamCopy(bool enabled)
+{
+    m_settings.setValue("video/smartCopy", enabled);
+}
+
+bool Settings::contentTuning() const
+{
+    return m_settings.value("video/contentTuning", true).toBool();
+}
+
+void Settings::setContentTuning(bool enabled)
+{
+    m_settings.setValue("video/contentTuning", enabled);
+}
+
+int Settings::av1Preset() const
+{
+    return m_settings.value("av1/preset", -1).toInt();
+}
+
+void Settings::setAv1Preset(int preset)
+{
+    m_settings.setValue("av1/preset", qBound(-1, preset, 13));
+}
+
+int Settings::av1TileColumns() const
+{
+    return m_settings.value("av1/tileColumns", -1).toInt();
+}
+
+void Settings::setAv1TileColumns(int columns)
+{
+    m_settings.setValue("av1/tileColumns", qBound(-1, columns, 4));
+}
+
+int Settings::av1TileRows() const
+{
+    return m_settings.value("av1/tileRows", -1).toInt();
+}
+
+void Settings::setAv1TileRows(int rows)
+{
+    m_settings.setValue("av1/tileRows", qBound(-1, rows, 4));
+}
+
+int Settings::av1Lookahead() const
+{
+    return m_settings.value("av1/lookahead", -1).toInt();
+}
+
+void Settings::setAv1Lookahead(int frames)
+{
+    m_settings.setValue("av1/lookahead", qBound(-1, frames, 120));
+}
+
+int Settings::av1MaxThreads() const
+{
+    return m_settings.value("av1/maxThreads", 0).toInt();
+}
+
+void Settings::setAv1MaxThreads(int threads)
+{
+    m_settings.setValue("av1/maxThreads", qMax(0, threads));
+}
+
 bool Settings::preserveAudio() const
 {
     return m_settings.value("video/preserveAudio", true).toBool();
@@ -385,3 +564,13 @@ void Settings::setVipsPath(const QString& path)
 {
     m_settings.setValue("paths/vips", path);
 }
+
+bool Settings::inProcessVideo() const
+{
+    return m_settings.value("paths/inProcessVideo", true).toBool();
+}
+
+void Settings::setInProcessVideo(bool enabled)
+{
+    m_settings.setValue("paths/inProcessVideo", enabled);
+}
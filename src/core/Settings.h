@@ -36,6 +36,21 @@ public:
     int threadCount() const;
     void setThreadCount(int count);
     
+    int maxVideoJobs() const;
+    void setMaxVideoJobs(int count);
+    
+    int maxImageJobs() const;
+    void setMaxImageJobs(int count);
+    
+    QString schedulingPolicy() const;
+    void setSchedulingPolicy(const QString& policy);
+    
+    int expressSlots() const;
+    void setExpressSlots(int count);
+    
+    bool preemptForExpress() const;
+    void setPreemptForExpress(bool preempt);
+    
     QString theme() const;
     void setTheme(const QString& theme);
     
@@ -83,9 +98,49 @@ public:
     int videoCrf() const;
     void setVideoCrf(int crf);
     
+    // "target_quality" mode: search the largest CRF whose samples still score this high
+    QString videoQualityMetric() const;     // vmaf, ssim or psnr
+    void setVideoQualityMetric(const QString& metric);
+    
+    double videoTargetQuality() const;
+    void setVideoTargetQuality(double target);
+    
     QString videoPreset() const;
     void setVideoPreset(const QString& preset);
     
+    // Split long videos at keyframes and encode the pieces in parallel
+    bool chunkedEncode() const;
+    void setChunkedEncode(bool enabled);
+    
+    // Number of chunks per video; 0 picks one from the job's thread budget
+    int videoChunkCount() const;
+    void setVideoChunkCount(int count);
+    
+    // Remux streams that already match the target codec and bitrate instead of re-encoding
+    bool smartStreamCopy() const;
+    void setSmartStreamCopy(bool enabled);
+    
+    // Classify each video (screen, animation, grain) and tune the encoder for it
+    bool contentTuning() const;
+    void setContentTuning(bool enabled);
+    
+    // SVT-AV1; -1 derives the value from the compression mode and resolution
+    int av1Preset() const;              // 0 = slowest/best, 13 = fastest
+    void setAv1Preset(int preset);
+    
+    int av1TileColumns() const;         // log2 of the tile count
+    void setAv1TileColumns(int columns);
+    
+    int av1TileRows() const;
+    void setAv1TileRows(int rows);
+    
+    int av1Lookahead() const;           // frames
+    void setAv1Lookahead(int frames);
+    
+    // Caps the encoder's logical processors below the job's thread budget; 0 = no cap
+    int av1MaxThreads() const;
+    void setAv1MaxThreads(int threads);
+    
     bool preserveAudio() const;
     void setPreserveAudio(bool preserve);
     
@@ -117,6 +172,10 @@ public:
     
     QString vipsPath() const;
     void setVipsPath(const QString& path);
+    
+    // Encode videos with the linked FFmpeg libraries; the ffmpeg binary remains the fallback
+    bool inProcessVideo() const;
+    void setInProcessVideo(bool enabled);
 
 private:
     Settings();
@@ -0,0 +1,201 @@
+/**
+ * @file ThroughputHistory.cpp
+ * @brief Throughput history and cost model implementation
+ */
+
+#include "ThroughputHistory.h"
+#include "Job.h"
+#include "EncodeProfile.h"
+#include "FileUtils.h"
+#include "Logger.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+
+ThroughputHistory::ThroughputHistory()
+{
+    load();
+}
+
+ThroughputHistory& ThroughputHistory::instance()
+{
+    static ThroughputHistory instance;
+    return instance;
+}
+
+QString ThroughputHistory::profileKey(const Job& job)
+{
+    const EncodeProfile& profile = job.profile();
+    
+    if (job.type() == JobType::Video) {
+        QString preset = profile.videoCodec == "av1" ? QString::number(profile.av1Preset)
+                                                     : profile.videoPreset;
+        return QString("video/%1/%2/%3/%4")
+            .arg(profile.videoCodec, preset, profile.videoCompressionMode,
+                 profile.useGpu ? "gpu" : "cpu");
+    }
+    
+    return QString("image/%1/%2").arg(profile.imageOutputFormat, profile.imageCompressionMode);
+}
+
+void ThroughputHistory::record(const ThroughputRecord& record)
+{
+    if (record.work <= 0 || record.coreSeconds <= 0) return;
+    
+    QMutexLocker locker(&m_mutex);
+    
+    // Drop the oldest quarter at once rather than shifting on every insert
+    if (static_cast<int>(m_records.size()) >= MaxRecords) {
+        m_records.erase(m_records.begin(), m_records.begin() + MaxRecords / 4);
+        m_models.clear();
+    }
+    
+    m_records.push_back(record);
+    m_dirty = true;
+    
+    // Every CRF and content variant of the profile may include the new record
+    QString prefix = record.profileKey + '|';
+    for (auto it = m_models.begin(); it != m_models.end(); ) {
+        if (it.key().startsWith(prefix)) {
+            it = m_models.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool ThroughputHistory::predict(const QString& profileKey, double work, double& coreSeconds,
+                                int crf, const QString& contentClass) const
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QString key = modelKey(profileKey, crf, contentClass);
+    auto it = m_models.constFind(key);
+    if (it == m_models.constEnd()) {
+        it = m_models.insert(key, fit(profileKey, crf, contentClass));
+    }
+    if (!it->valid) return false;
+    
+    coreSeconds = it->intercept + it->slope * work;
+    return true;
+}
+
+QString ThroughputHistory::modelKey(const QString& profileKey, int crf, const QString& contentClass)
+{
+    return QString("%1|%2|%3").arg(profileKey).arg(crf < 0 ? -1 : crf / CrfBucketWidth).arg(contentClass);
+}
+
+ThroughputHistory::Model ThroughputHistory::fit(const QString& profileKey, int crf,
+                                                const QString& contentClass) const
+{
+    // Newest first; records from this machine win when there are enough of them,
+    // since core counts and clocks change the per-core rate. Decimated screen captures,
+    // tuned grain and low CRFs cost very different amounts per pixel, so they only
+    // feed models of their own kind
+    const int hostCores = QThread::idealThreadCount();
+    std::vector<const ThroughputRecord*> local;
+    std::vector<const ThroughputRecord*> any;
+    for (auto it = m_records.crbegin(); it != m_records.crend(); ++it) {
+        if (it->profileKey != profileKey) continue;
+        if (crf >= 0 && (it->crf < 0 || it->crf / CrfBucketWidth != crf / CrfBucketWidth)) continue;
+        if (!contentClass.isEmpty() && it->contentClass != contentClass) continue;
+        if (static_cast<int>(any.size()) < MaxSamplesPerModel) any.push_back(&*it);
+        if (it->hostCores == hostCores) {
+            local.push_back(&*it);
+            if (static_cast<int>(local.size()) >= MaxSamplesPerModel) break;
+        }
+    }
+    
+    const auto& samples = static_cast<int>(local.size()) >= MinSamples ? local : any;
+    Model model;
+    if (static_cast<int>(samples.size()) < MinSamples) return model;
+    
+    double n = static_cast<double>(samples.size());
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (const ThroughputRecord* sample : samples) {
+        sumX += sample->work;
+        sumY += sample->coreSeconds;
+        sumXX += sample->work * sample->work;
+        sumXY += sample->work * sample->coreSeconds;
+    }
+    
+    // Least squares captures the fixed per-file startup cost; similar-sized files
+    // or a negative fit fall back to the plain average rate
+    double denominator = n * sumXX - sumX * sumX;
+    if (denominator > 1e-9 * sumXX * n) {
+        model.slope = (n * sumXY - sumX * sumY) / denominator;
+        model.intercept = (sumY - model.slope * sumX) / n;
+    }
+    if (model.slope <= 0 || model.intercept < 0) {
+        model.slope = sumY / sumX;
+        model.intercept = 0;
+    }
+    
+    model.valid = model.slope > 0;
+    return model;
+}
+
+void ThroughputHistory::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) return;
+    
+    QString path = cachePath();
+    FileUtils::ensureDirectoryExists(QFileInfo(path).absolutePath());
+    
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        Logger::warning("Failed to write throughput history: " + path);
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << CacheVersion << static_cast<qint32>(m_records.size());
+    for (const auto& record : m_records) {
+        stream << record.profileKey << record.timestamp << record.width << record.height
+               << record.duration << record.inputBytes << record.outputBytes << record.work
+               << record.coreSeconds << record.threads << record.hostCores
+               << record.crf << record.contentClass;
+    }
+    
+    if (file.commit()) {
+        m_dirty = false;
+    }
+}
+
+void ThroughputHistory::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    qint32 version = 0;
+    qint32 count = 0;
+    stream >> version >> count;
+    if (version != CacheVersion) return;
+    
+    m_records.reserve(qBound(0, count, MaxRecords));
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        ThroughputRecord record;
+        stream >> record.profileKey >> record.timestamp >> record.width >> record.height
+               >> record.duration >> record.inputBytes >> record.outputBytes >> record.work
+               >> record.coreSeconds >> record.threads >> record.hostCores
+               >> record.crf >> record.contentClass;
+        m_records.push_back(std::move(record));
+    }
+    
+    // A truncated history only costs estimate accuracy; start over
+    if (stream.status() != QDataStream::Ok) {
+        m_records.clear();
+    }
+}
+
+QString ThroughputHistory::cachePath() const
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QString("%1/throughput-history.dat").arg(dataDir);
+}
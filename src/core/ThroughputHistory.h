@@ -0,0 +1,86 @@
+/**
+ * @file ThroughputHistory.h
+ * @brief Persistent per-profile encode throughput records and fitted cost models
+ */
+
+#ifndef THROUGHPUTHISTORY_H
+#define THROUGHPUTHISTORY_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <vector>
+
+class Job;
+
+// One finished job; "work" is pixels encoded for videos and input bytes for images,
+// so pixels per second and the compression ratio are derived rather than stored
+struct ThroughputRecord {
+    QString profileKey;
+    qint64 timestamp = 0;       // ms since epoch
+    qint32 width = 0;
+    qint32 height = 0;
+    double duration = 0;
+    qint64 inputBytes = 0;
+    qint64 outputBytes = 0;
+    double work = 0;
+    double coreSeconds = 0;
+    qint32 threads = 0;
+    qint32 hostCores = 0;
+    qint32 crf = -1;            // CRF the video encode ran at; -1 for images
+    QString contentClass;       // VideoProcessor's content class; empty for images
+};
+
+class ThroughputHistory
+{
+public:
+    static ThroughputHistory& instance();
+
+    // Groups jobs whose throughput is comparable: media type, codec or format,
+    // preset, compression mode and GPU use
+    static QString profileKey(const Job& job);
+
+    // Thread-safe; invalidates the model of the record's profile
+    void record(const ThroughputRecord& record);
+    
+    // Core-seconds to process @p work units under @p profileKey; false until the
+    // profile has enough history to fit a model. A known @p crf and @p contentClass
+    // narrow the history to encodes that ran at a similar CRF on similar content
+    bool predict(const QString& profileKey, double work, double& coreSeconds,
+                 int crf = -1, const QString& contentClass = QString()) const;
+    
+    // Persists new records; survives JobQueue::clear() and restarts
+    void save();
+
+private:
+    ThroughputHistory();
+    ~ThroughputHistory() = default;
+    ThroughputHistory(const ThroughputHistory&) = delete;
+    ThroughputHistory& operator=(const ThroughputHistory&) = delete;
+
+    // coreSeconds = intercept + slope * work
+    struct Model {
+        double intercept = 0;
+        double slope = 0;
+        bool valid = false;
+    };
+
+    Model fit(const QString& profileKey, int crf, const QString& contentClass) const;
+    static QString modelKey(const QString& profileKey, int crf, const QString& contentClass);
+    void load();
+    QString cachePath() const;
+
+    static constexpr int MinSamples = 3;
+    static constexpr int MaxSamplesPerModel = 200;
+    static constexpr int MaxRecords = 20000;
+    static constexpr int CrfBucketWidth = 4;
+    static constexpr qint32 CacheVersion = 2;
+
+private:
+    std::vector<ThroughputRecord> m_records;
+    mutable QHash<QString, Model> m_models;
+    mutable QMutex m_mutex;
+    bool m_dirty = false;
+};
+
+#endif // THROUGHPUTHISTORY_H
@@ -15,7 +15,7 @@
 #include "MainWindow.h"
 #include "ThemeManager.h"
 #include "Settings.h"
-#include "GPUDetector.h"
+#include "CapabilityRegistry.h"
 #include "Logger.h"
 
 int main(int argc, char *argv[])
@@ -54,9 +54,8 @@ int main(int argc, char *argv[])
     ThemeManager::instance().initialize();
     ThemeManager::instance().applyTheme(Settings::instance().theme());
     
-    // Detect GPU capabilities
-    GPUDetector detector;
-    auto gpuInfo = detector.detect();
+    // Detect GPU capabilities once; encoders and the settings dialog reuse the result
+    GPUInfo gpuInfo = CapabilityRegistry::instance().gpuInfo();
     
     if (gpuInfo.hasNvidia) {
         Logger::info(QString("NVIDIA GPU detected: %1").arg(gpuInfo.deviceName));
@@ -0,0 +1,197 @@
+/**
+ * @file CapabilityRegistry.cpp
+ * @brief Capability registry implementation
+ */
+
+#include "CapabilityRegistry.h"
+#include "FileUtils.h"
+#include "Logger.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+CapabilityRegistry::CapabilityRegistry()
+{
+    load();
+}
+
+CapabilityRegistry& CapabilityRegistry::instance()
+{
+    static CapabilityRegistry instance;
+    return instance;
+}
+
+GPUInfo CapabilityRegistry::gpuInfo()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_gpuDetected) {
+        GPUDetector detector;
+        m_gpuInfo = detector.detect();
+        m_gpuDetected = true;
+    }
+    return m_gpuInfo;
+}
+
+FFmpegCapabilitiesPtr CapabilityRegistry::ffmpeg(const QString& ffmpegPath)
+{
+    // Key on the real binary so a bare "ffmpeg" picks up PATH changes
+    QString executable = ffmpegPath;
+    if (!QFileInfo(executable).isAbsolute()) {
+        QString found = QStandardPaths::findExecutable(executable);
+        if (!found.isEmpty()) executable = found;
+    }
+    
+    QFileInfo info(executable);
+    qint64 size = info.exists() ? info.size() : 0;
+    qint64 modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    
+    QMutexLocker locker(&m_mutex);
+    auto it = m_ffmpeg.constFind(executable);
+    if (it != m_ffmpeg.constEnd() && it->size == size && it->modified == modified) {
+        return it->capabilities;
+    }
+    
+    // Probed under the lock: concurrent first jobs wait for one probe instead of each spawning
+    FFmpegCapabilitiesPtr capabilities = probe(executable);
+    m_ffmpeg.insert(executable, {size, modified, capabilities});
+    if (capabilities->usable) {
+        save();
+    }
+    return capabilities;
+}
+
+FFmpegCapabilitiesPtr CapabilityRegistry::probe(const QString& executable)
+{
+    auto capabilities = std::make_shared<FFmpegCapabilities>();
+    capabilities->path = executable;
+    
+    auto run = [&executable](const QStringList& args, QString& output) {
+        QProcess process;
+        process.start(executable, args);
+        if (!process.waitForFinished(5000) || process.exitCode() != 0) {
+            process.kill();
+            return false;
+        }
+        output = QString::fromUtf8(process.readAllStandardOutput());
+        return true;
+    };
+    
+    QString output;
+    if (!run({"-hide_banner", "-version"}, output)) {
+        Logger::warning(QString("FFmpeg is not usable: %1").arg(executable));
+        return capabilities;
+    }
+    capabilities->usable = true;
+    capabilities->version = output.section('\n', 0, 0).trimmed();
+    
+    // " V....D libx265   libx265 H.265 / HEVC"; the legend lines capture "="
+    if (run({"-hide_banner", "-encoders"}, output)) {
+        static const QRegularExpression encoderLine(R"(^\s*[VAS][A-Z.]{5}\s+(\S+))",
+                                                    QRegularExpression::MultilineOption);
+        auto matches = encoderLine.globalMatch(output);
+        while (matches.hasNext()) {
+            capabilities->encoders.insert(matches.next().captured(1));
+        }
+        capabilities->encoders.remove("=");
+    }
+    
+    // One method per line after the "Hardware acceleration methods:" header
+    if (run({"-hide_banner", "-hwaccels"}, output)) {
+        const QStringList lines = output.split('\n', Qt::SkipEmptyParts);
+        for (const QString& line : lines) {
+            QString method = line.trimmed();
+            if (!method.isEmpty() && !method.endsWith(':')) {
+                capabilities->hwaccels.insert(method);
+            }
+        }
+    }
+    
+    // " TSC libvmaf  VV->V  Calculate the VMAF..."; older builds print two flag columns
+    if (run({"-hide_banner", "-filters"}, output)) {
+        static const QRegularExpression filterLine(R"(^\s*[TSC.]{2,3}\s+(\S+)\s+\S*->\S*)",
+                                                   QRegularExpression::MultilineOption);
+        auto matches = filterLine.globalMatch(output);
+        while (matches.hasNext()) {
+            capabilities->filters.insert(matches.next().captured(1));
+        }
+    }
+    
+    Logger::info(QString("FFmpeg capabilities: %1 (%2 encoders, %3 filters, hwaccels: %4)")
+        .arg(capabilities->version)
+        .arg(capabilities->encoders.size())
+        .arg(capabilities->filters.size())
+        .arg(QStringList(capabilities->hwaccels.values()).join(", ")));
+    return capabilities;
+}
+
+void CapabilityRegistry::save()
+{
+    // Caller holds m_mutex
+    QString path = cachePath();
+    FileUtils::ensureDirectoryExists(QFileInfo(path).absolutePath());
+    
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        Logger::warning("Failed to write encoder capability cache: " + path);
+        return;
+    }
+    
+    QDataStream stream(&file);
+    qint32 count = 0;
+    for (const auto& entry : m_ffmpeg) {
+        if (entry.capabilities->usable) count++;
+    }
+    
+    stream << CacheVersion << count;
+    for (auto it = m_ffmpeg.constBegin(); it != m_ffmpeg.constEnd(); ++it) {
+        const FFmpegCapabilities& capabilities = *it->capabilities;
+        if (!capabilities.usable) continue;
+        stream << it.key() << it->size << it->modified
+               << capabilities.version << capabilities.encoders << capabilities.hwaccels
+               << capabilities.filters;
+    }
+    
+    file.commit();
+}
+
+void CapabilityRegistry::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    qint32 version = 0;
+    qint32 count = 0;
+    stream >> version >> count;
+    if (version != CacheVersion) return;
+    
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        CacheEntry entry;
+        auto capabilities = std::make_shared<FFmpegCapabilities>();
+        stream >> path >> entry.size >> entry.modified
+               >> capabilities->version >> capabilities->encoders >> capabilities->hwaccels
+               >> capabilities->filters;
+        capabilities->path = path;
+        capabilities->usable = true;
+        entry.capabilities = capabilities;
+        m_ffmpeg.insert(path, entry);
+    }
+    
+    // A truncated cache only costs one more probe
+    if (stream.status() != QDataStream::Ok) {
+        m_ffmpeg.clear();
+    }
+}
+
+QString CapabilityRegistry::cachePath() const
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QString("%1/encoder-capabilities.dat").arg(dataDir);
+}
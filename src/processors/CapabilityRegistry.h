@@ -0,0 +1,71 @@
+/**
+ * @file CapabilityRegistry.h
+ * @brief Process-wide cache of GPU and FFmpeg encoder capabilities
+ */
+
+#ifndef CAPABILITYREGISTRY_H
+#define CAPABILITYREGISTRY_H
+
+#include <QString>
+#include <QSet>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+
+#include "GPUDetector.h"
+
+// What one ffmpeg binary can do; probed once per binary version
+struct FFmpegCapabilities {
+    QString path;
+    bool usable = false;
+    QString version;
+    QSet<QString> encoders;     // e.g. libx265, libsvtav1, hevc_nvenc
+    QSet<QString> hwaccels;     // e.g. cuda, vaapi, qsv
+    QSet<QString> filters;      // e.g. libvmaf, ssim, mpdecimate
+    
+    bool hasEncoder(const QString& name) const { return encoders.contains(name); }
+    bool hasHwaccel(const QString& name) const { return hwaccels.contains(name); }
+    bool hasFilter(const QString& name) const { return filters.contains(name); }
+};
+
+using FFmpegCapabilitiesPtr = std::shared_ptr<const FFmpegCapabilities>;
+
+class CapabilityRegistry
+{
+public:
+    static CapabilityRegistry& instance();
+
+    // Detected on first call, then shared for the rest of the session
+    GPUInfo gpuInfo();
+    
+    // Thread-safe; probes a binary only when its mtime or size differ from the
+    // persisted entry, so every later job is a hash lookup
+    FFmpegCapabilitiesPtr ffmpeg(const QString& ffmpegPath);
+
+private:
+    CapabilityRegistry();
+    ~CapabilityRegistry() = default;
+    CapabilityRegistry(const CapabilityRegistry&) = delete;
+    CapabilityRegistry& operator=(const CapabilityRegistry&) = delete;
+
+    struct CacheEntry {
+        qint64 size = 0;
+        qint64 modified = 0;
+        FFmpegCapabilitiesPtr capabilities;
+    };
+
+    static FFmpegCapabilitiesPtr probe(const QString& executable);
+    void load();
+    void save();
+    QString cachePath() const;
+    
+    static constexpr qint32 CacheVersion = 2;
+
+private:
+    QMutex m_mutex;
+    QHash<QString, CacheEntry> m_ffmpeg;
+    bool m_gpuDetected = false;
+    GPUInfo m_gpuInfo;
+};
+
+#endif // CAPABILITYREGISTRY_H
@@ -0,0 +1,111 @@
+/**
+ * @file CrfSearchCache.cpp
+ * @brief CRF search cache implementation
+ */
+
+#include "CrfSearchCache.h"
+#include "FileUtils.h"
+#include "Logger.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+CrfSearchCache::CrfSearchCache()
+{
+    load();
+}
+
+CrfSearchCache& CrfSearchCache::instance()
+{
+    static CrfSearchCache instance;
+    return instance;
+}
+
+QString CrfSearchCache::keyFor(const QString& inputPath, const QString& setup)
+{
+    return QFileInfo(inputPath).absoluteFilePath() + '\n' + setup;
+}
+
+int CrfSearchCache::lookup(const QString& inputPath, const QString& setup)
+{
+    QFileInfo info(inputPath);
+    if (!info.exists()) return -1;
+    
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(keyFor(inputPath, setup));
+    if (it == m_entries.constEnd() || it->size != info.size() ||
+        it->modified != info.lastModified().toMSecsSinceEpoch()) {
+        return -1;
+    }
+    return it->crf;
+}
+
+void CrfSearchCache::store(const QString& inputPath, const QString& setup, int crf)
+{
+    QFileInfo info(inputPath);
+    if (!info.exists()) return;
+    
+    QMutexLocker locker(&m_mutex);
+    
+    // Results are cheap to recompute; an arbitrary eviction keeps the file bounded
+    if (m_entries.size() >= MaxEntries) {
+        m_entries.erase(m_entries.begin());
+    }
+    
+    m_entries.insert(keyFor(inputPath, setup),
+                     {info.size(), info.lastModified().toMSecsSinceEpoch(), crf});
+    save();
+}
+
+void CrfSearchCache::save()
+{
+    // Caller holds m_mutex
+    QString path = cachePath();
+    FileUtils::ensureDirectoryExists(QFileInfo(path).absolutePath());
+    
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        Logger::warning("Failed to write CRF search cache: " + path);
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << static_cast<qint32>(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->size << it->modified << it->crf;
+    }
+    
+    file.commit();
+}
+
+void CrfSearchCache::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    qint32 count = 0;
+    stream >> count;
+    
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString key;
+        Entry entry;
+        stream >> key >> entry.size >> entry.modified >> entry.crf;
+        m_entries.insert(key, entry);
+    }
+    
+    // A truncated cache only costs a few searches
+    if (stream.status() != QDataStream::Ok) {
+        m_entries.clear();
+    }
+}
+
+QString CrfSearchCache::cachePath() const
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QString("%1/crf-search.dat").arg(dataDir);
+}
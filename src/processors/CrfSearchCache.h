@@ -0,0 +1,48 @@
+/**
+ * @file CrfSearchCache.h
+ * @brief Persistent cache of target-quality CRF search results
+ */
+
+#ifndef CRFSEARCHCACHE_H
+#define CRFSEARCHCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+// One entry per input file and search setup (encoder, preset, metric, target);
+// a file that changes on disk is searched again
+class CrfSearchCache
+{
+public:
+    static CrfSearchCache& instance();
+
+    // Returns -1 when the file has not been searched with this setup
+    int lookup(const QString& inputPath, const QString& setup);
+    void store(const QString& inputPath, const QString& setup, int crf);
+
+private:
+    CrfSearchCache();
+    ~CrfSearchCache() = default;
+    CrfSearchCache(const CrfSearchCache&) = delete;
+    CrfSearchCache& operator=(const CrfSearchCache&) = delete;
+
+    struct Entry {
+        qint64 size = 0;
+        qint64 modified = 0;
+        qint32 crf = -1;
+    };
+
+    static QString keyFor(const QString& inputPath, const QString& setup);
+    void load();
+    void save();
+    QString cachePath() const;
+
+    static constexpr int MaxEntries = 20000;
+
+private:
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+#endif // CRFSEARCHCACHE_H
@@ -0,0 +1,78 @@
+/**
+ * @file FFmpegProgressParser.cpp
+ * @brief ffmpeg progress stream parser implementation
+ */
+
+#include "FFmpegProgressParser.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// "N/A" and other non-numeric values parse as 0
+double toDouble(const char* value)
+{
+    return std::strtod(value, nullptr);
+}
+
+qint64 toInt(const char* value)
+{
+    return std::strtoll(value, nullptr, 10);
+}
+
+} // namespace
+
+bool FFmpegProgressParser::feed(const char* data, qint64 size)
+{
+    m_blockEnded = false;
+    
+    for (qint64 i = 0; i < size; ++i) {
+        char c = data[i];
+        if (c == '\n') {
+            if (!m_overflow) {
+                m_line[m_length] = '\0';
+                parseLine();
+            }
+            m_length = 0;
+            m_overflow = false;
+        } else if (c != '\r') {
+            if (m_length < MaxLineLength) {
+                m_line[m_length++] = c;
+            } else {
+                m_overflow = true;
+            }
+        }
+    }
+    
+    return m_blockEnded;
+}
+
+void FFmpegProgressParser::parseLine()
+{
+    char* separator = std::strchr(m_line, '=');
+    if (!separator) return;
+    
+    *separator = '\0';
+    const char* key = m_line;
+    const char* value = separator + 1;
+    
+    if (std::strcmp(key, "frame") == 0) {
+        m_pending.frame = toInt(value);
+    } else if (std::strcmp(key, "fps") == 0) {
+        m_pending.fps = toDouble(value);
+    } else if (std::strcmp(key, "bitrate") == 0) {
+        m_pending.bitrateKbps = toDouble(value);          // "1234.5kbits/s"
+    } else if (std::strcmp(key, "total_size") == 0) {
+        m_pending.totalSize = toInt(value);
+    } else if (std::strcmp(key, "out_time_us") == 0) {
+        m_pending.outTimeUs = toInt(value);
+    } else if (std::strcmp(key, "speed") == 0) {
+        m_pending.speed = toDouble(value);                // "1.23x"
+    } else if (std::strcmp(key, "progress") == 0) {
+        // Every block ends with progress=continue or progress=end
+        m_pending.finished = std::strcmp(value, "end") == 0;
+        m_current = m_pending;
+        m_blockEnded = true;
+    }
+}
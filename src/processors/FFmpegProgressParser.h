@@ -0,0 +1,49 @@
+/**
+ * @file FFmpegProgressParser.h
+ * @brief Incremental parser for ffmpeg's -progress key=value stream
+ */
+
+#ifndef FFMPEGPROGRESSPARSER_H
+#define FFMPEGPROGRESSPARSER_H
+
+#include <QtGlobal>
+
+// One "-progress" report; ffmpeg emits a block roughly every 0.5 s
+struct FFmpegProgress {
+    qint64 frame = 0;
+    double fps = 0;
+    double bitrateKbps = 0;
+    qint64 totalSize = 0;       // bytes written so far
+    qint64 outTimeUs = 0;       // position reached in the output
+    double speed = 0;           // multiple of realtime
+    bool finished = false;      // "progress=end"
+    
+    double outTimeSeconds() const { return outTimeUs / 1000000.0; }
+};
+
+class FFmpegProgressParser
+{
+public:
+    // Accepts arbitrary chunks; lines split across reads are carried over.
+    // Returns true when at least one complete block ended in this chunk.
+    bool feed(const char* data, qint64 size);
+    
+    // Last complete block
+    const FFmpegProgress& current() const { return m_current; }
+
+private:
+    void parseLine();
+
+private:
+    // Longest real line is well under this; longer ones are skipped
+    static constexpr int MaxLineLength = 128;
+    
+    char m_line[MaxLineLength + 1] = {};
+    int m_length = 0;
+    bool m_overflow = false;
+    bool m_blockEnded = false;
+    FFmpegProgress m_pending;
+    FFmpegProgress m_current;
+};
+
+#endif // FFMPEGPROGRESSPARSER_H
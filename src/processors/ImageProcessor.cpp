@@ -5,8 +5,9 @@
 
 #include "ImageProcessor.h"
 #include "Job.h"
-#include "Settings.h"
 #include "Logger.h"
+#include "OutputRing.h"
+#include "ProcessUtils.h"
 
 #include <QImage>
 #include <QImageReader>
@@ -22,6 +23,19 @@
 extern "C" {
 #include <vips/vips.h>
 }
+
+// Runs on libvips worker threads while a pipeline is evaluated
+static void onVipsEval(VipsImage* image, VipsProgress* progress, gpointer user)
+{
+    Q_UNUSED(progress)
+    
+    // Parking here pauses the pipeline between tiles
+    auto* job = static_cast<Job*>(user);
+    job->waitWhilePaused();
+    if (job->isCancelRequested()) {
+        vips_image_set_kill(image, TRUE);
+    }
+}
 #endif
 
 ImageProcessor::ImageProcessor()
@@ -81,6 +95,15 @@ void ImageProcessor::setProgressCallback(std::function<void(int)> callback)
     m_progressCallback = callback;
 }
 
+void ImageProcessor::setConcurrency(int threads)
+{
+#ifdef MEDIAFORGE_HAS_VIPS
+    vips_concurrency_set(qMax(1, threads));
+#else
+    Q_UNUSED(threads)
+#endif
+}
+
 void ImageProcessor::reportProgress(int progress)
 {
     if (m_progressCallback) {
@@ -91,22 +114,25 @@ void ImageProcessor::reportProgress(int progress)
 bool ImageProcessor::processWithVips(Job* job)
 {
 #ifdef MEDIAFORGE_HAS_VIPS
-    const auto& settings = Settings::instance();
+    const EncodeProfile& profile = job->profile();
     QString outputFormat = job->outputFormat().toLower();
-    bool lossless = settings.imageCompressionMode() == "lossless";
+    bool lossless = profile.imageLossless();
 
     reportProgress(20);
 
-    VipsImage* image = nullptr;
-
     // Load image
-    if (vips_image_new_from_file(job->inputPath().toUtf8().constData(),
-                                  "access", VIPS_ACCESS_SEQUENTIAL,
-                                  nullptr) == nullptr) {
+    VipsImage* image = vips_image_new_from_file(job->inputPath().toUtf8().constData(),
+                                                "access", VIPS_ACCESS_SEQUENTIAL,
+                                                nullptr);
+    if (image == nullptr) {
         m_lastError = "Failed to load image with libvips";
         return false;
     }
 
+    // Lets a cancel request abort the save between tiles
+    vips_image_set_progress(image, TRUE);
+    g_signal_connect(image, "eval", G_CALLBACK(onVipsEval), job);
+
     reportProgress(40);
 
     // Save with appropriate format
@@ -115,19 +141,19 @@ bool ImageProcessor::processWithVips(Job* job)
     if (outputFormat == "jxl") {
         result = vips_jxlsave(image, job->outputPath().toUtf8().constData(),
                               "lossless", lossless ? TRUE : FALSE,
-                              "effort", settings.jpegXlEffort(),
+                              "effort", profile.jpegXlEffort,
                               nullptr);
     } else if (outputFormat == "avif") {
         result = vips_heifsave(image, job->outputPath().toUtf8().constData(),
                                "compression", VIPS_FOREIGN_HEIF_COMPRESSION_AV1,
                                "lossless", lossless ? TRUE : FALSE,
-                               "speed", settings.avifSpeed(),
+                               "speed", profile.avifSpeed,
                                nullptr);
     } else if (outputFormat == "webp") {
         result = vips_webpsave(image, job->outputPath().toUtf8().constData(),
                                "lossless", lossless ? TRUE : FALSE,
-                               "Q", settings.imageQuality(),
-                               "effort", settings.webpMethod(),
+                               "Q", profile.imageQuality,
+                               "effort", profile.webpMethod,
                                nullptr);
     } else if (outputFormat == "png") {
         result = vips_pngsave(image, job->outputPath().toUtf8().constData(),
@@ -143,6 +169,12 @@ bool ImageProcessor::processWithVips(Job* job)
 
     reportProgress(90);
 
+    if (job->isCancelRequested()) {
+        m_lastError = "Cancelled";
+        vips_error_clear();
+        return false;
+    }
+
     if (result != 0) {
         m_lastError = QString("Failed to save image: %1").arg(vips_error_buffer());
         vips_error_clear();
@@ -158,7 +190,7 @@ bool ImageProcessor::processWithVips(Job* job)
 
 bool ImageProcessor::processWithQt(Job* job)
 {
-    const auto& settings = Settings::instance();
+    const EncodeProfile& profile = job->profile();
     QString outputFormat = job->outputFormat().toLower();
     QString outputPath = job->outputPath();
 
@@ -179,6 +211,13 @@ bool ImageProcessor::processWithQt(Job* job)
         .arg(image.width()).arg(image.height()).arg(image.format()));
     reportProgress(50);
 
+    // QImage cannot be interrupted, so check between the load and the save
+    job->waitWhilePaused();
+    if (job->isCancelRequested()) {
+        m_lastError = "Cancelled";
+        return false;
+    }
+
     // Ensure output directory exists
     QFileInfo outputInfo(outputPath);
     QDir outputDir = outputInfo.absoluteDir();
@@ -196,6 +235,9 @@ bool ImageProcessor::processWithQt(Job* job)
         if (convertWithExternalTool(job)) {
             return true;
         }
+        if (job->isCancelRequested()) {
+            return false;
+        }
         Logger::warning("Vips failed, falling back to Qt if possible");
     }
 
@@ -204,11 +246,11 @@ bool ImageProcessor::processWithQt(Job* job)
     // Determine quality
     int quality = -1; // -1 means default
     if (outputFormat == "jpg" || outputFormat == "jpeg") {
-        quality = settings.imageQuality();
+        quality = profile.imageQuality;
     } else if (outputFormat == "png") {
         quality = 100; // For PNG, this affects compression (100 = maximum compression)
     } else if (outputFormat == "webp") {
-        quality = settings.imageCompressionMode() == "lossless" ? 100 : settings.imageQuality();
+        quality = profile.imageLossless() ? 100 : profile.imageQuality;
     }
 
     // Use QImage::save directly - simpler and more reliable
@@ -257,16 +299,17 @@ bool ImageProcessor::processWithQt(Job* job)
 
 bool ImageProcessor::convertWithExternalTool(Job* job)
 {
-    const auto& settings = Settings::instance();
+    const EncodeProfile& profile = job->profile();
     QString outputFormat = job->outputFormat().toLower();
-    bool lossless = settings.imageCompressionMode() == "lossless";
+    bool lossless = profile.imageLossless();
 
     // Try using ImageMagick or other tools
     QProcess process;
+    ProcessUtils::prepare(process);
     QStringList args;
 
     QString appDir = QCoreApplication::applicationDirPath();
-    QString vipsPath = settings.vipsPath(); 
+    QString vipsPath = profile.vipsPath; 
     // Auto-detect bundled vips if not set
     if (vipsPath.isEmpty()) {
         QString bundledVips = appDir + "/vips/bin/vips.exe";
@@ -284,24 +327,24 @@ bool ImageProcessor::convertWithExternalTool(Job* job)
         // Add encoder options
         QString options;
         if (outputFormat == "jxl") {
-            options = QString("effort=%1").arg(settings.jpegXlEffort());
+            options = QString("effort=%1").arg(profile.jpegXlEffort);
             if (lossless) {
                  options += ",lossless=true";
             } else {
-                 options += QString(",Q=%1").arg(settings.imageQuality());
+                 options += QString(",Q=%1").arg(profile.imageQuality);
             }
         } else if (outputFormat == "avif") {
-            options = QString("speed=%1").arg(settings.avifSpeed());
+            options = QString("speed=%1").arg(profile.avifSpeed);
              if (lossless) {
                  options += ",lossless=true";
             } else {
-                 options += QString(",Q=%1").arg(settings.imageQuality());
+                 options += QString(",Q=%1").arg(profile.imageQuality);
             }
         } else if (outputFormat == "webp") {
              if (lossless) {
                  options = "lossless=true";  // No leading comma!
             } else {
-                 options = QString("Q=%1").arg(settings.imageQuality());
+                 options = QString("Q=%1").arg(profile.imageQuality);
             }
         } else if (outputFormat == "png") {
             // Use vips for PNG too if falling back here
@@ -319,6 +362,7 @@ bool ImageProcessor::convertWithExternalTool(Job* job)
         QString vipsDir = QFileInfo(vipsPath).absolutePath(); // vips/bin
         QString path = env.value("PATH");
         env.insert("PATH", vipsDir + ";" + path);
+        env.insert("VIPS_CONCURRENCY", QString::number(qMax(1, job->threadBudget())));
         process.setProcessEnvironment(env);
         process.setWorkingDirectory(vipsDir); 
 
@@ -335,9 +379,10 @@ bool ImageProcessor::convertWithExternalTool(Job* job)
             if (lossless) {
                 args << "--lossless";
             } else {
-                args << "--min" << "0" << "--max" << QString::number(63 - settings.imageQuality() * 63 / 100);
+                args << "--min" << "0" << "--max" << QString::number(63 - profile.imageQuality * 63 / 100);
             }
-            args << "--speed" << QString::number(settings.avifSpeed());
+            args << "--speed" << QString::number(profile.avifSpeed);
+            args << "--jobs" << QString::number(qMax(1, job->threadBudget()));
             args << job->outputPath();
     
             process.start("avifenc", args);
@@ -347,8 +392,9 @@ bool ImageProcessor::convertWithExternalTool(Job* job)
             args << job->inputPath() << job->outputPath();
              // ... options ...
              if (lossless) args << "-d" << "0";
-             else args << "-d" << QString::number((100 - settings.imageQuality()) / 10.0);
-             args << "-e" << QString::number(settings.jpegXlEffort());
+             else args << "-d" << QString::number((100 - profile.imageQuality) / 10.0);
+             args << "-e" << QString::number(profile.jpegXlEffort);
+             args << QString("--num_threads=%1").arg(qMax(1, job->threadBudget()));
             process.start("cjxl", args);
         } else {
              m_lastError = "Vips not found and no other tool available.";
@@ -362,16 +408,29 @@ bool ImageProcessor::convertWithExternalTool(Job* job)
         return false;
     }
 
-    if (!process.waitForFinished(600000)) {  // 10 minute timeout
-        process.kill();
+    // Only the tail of a chatty tool's output is kept for the error report
+    OutputRing stdOutTail(OutputRing::DefaultCapacity / 4);
+    OutputRing stdErrTail;
+    auto waitResult = ProcessUtils::waitForFinished(process,
+        [job]() { return job->isCancelRequested(); },
+        [job]() { return job->isPauseRequested(); },
+        600000,  // 10 minute timeout, not counting time spent paused
+        &stdOutTail, &stdErrTail);
+
+    if (waitResult == ProcessWaitResult::Cancelled) {
+        m_lastError = "Cancelled";
+        return false;
+    }
+
+    if (waitResult == ProcessWaitResult::TimedOut) {
         m_lastError = "External tool timed out";
         Logger::error(m_lastError);
         return false;
     }
 
     if (process.exitCode() != 0) {
-        QString stdErr = QString::fromUtf8(process.readAllStandardError());
-        QString stdOut = QString::fromUtf8(process.readAllStandardOutput());
+        QString stdErr = stdErrTail.text();
+        QString stdOut = stdOutTail.text();
         m_lastError = QString("External tool failed (Code %1): %2. Output: %3")
             .arg(process.exitCode()).arg(stdErr).arg(stdOut);
         Logger::error(m_lastError);
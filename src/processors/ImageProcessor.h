@@ -21,6 +21,10 @@ public:
     QString lastError() const { return m_lastError; }
 
     void setProgressCallback(std::function<void(int)> callback);
+    
+    // libvips worker threads per image job; process-wide, so set once per batch
+    // from the image lane's share rather than by each job
+    static void setConcurrency(int threads);
 
 private:
     bool processWithVips(Job* job);
@@ -0,0 +1,574 @@
+/**
+ * @file LibavTranscoder.cpp
+ * @brief In-process video transcoder implementation
+ */
+
+#include "LibavTranscoder.h"
+#include "Job.h"
+#include "Logger.h"
+
+#ifdef MEDIAFORGE_HAS_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+}
+
+#include <cstring>
+
+// AVChannelLayout and swr_alloc_set_opts2() arrived with FFmpeg 5.1
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 37, 100)
+#define MEDIAFORGE_LIBAV_TRANSCODE 1
+#endif
+#endif
+
+#ifdef MEDIAFORGE_LIBAV_TRANSCODE
+
+namespace {
+
+QString avError(int code)
+{
+    char buffer[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, buffer, sizeof(buffer));
+    return QString::fromUtf8(buffer);
+}
+
+// One scaler per worker thread, reused across jobs while the geometry matches
+struct ScalerCache {
+    SwsContext* context = nullptr;
+    ~ScalerCache() { sws_freeContext(context); }
+};
+thread_local ScalerCache t_scaler;
+
+AVSampleFormat pickSampleFormat(const AVCodecContext* encoder, const AVCodec* codec,
+                                AVSampleFormat preferred)
+{
+    const AVSampleFormat* formats = nullptr;
+    int count = 0;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    avcodec_get_supported_config(encoder, codec, AV_CODEC_CONFIG_SAMPLE_FORMAT, 0,
+                                 reinterpret_cast<const void**>(&formats), &count);
+#else
+    Q_UNUSED(encoder)
+    formats = codec->sample_fmts;
+    while (formats && formats[count] != AV_SAMPLE_FMT_NONE) count++;
+#endif
+    if (!formats || count == 0) return preferred;
+
+    for (int i = 0; i < count; ++i) {
+        if (formats[i] == preferred) return preferred;
+    }
+    return formats[0];
+}
+
+int pickSampleRate(const AVCodecContext* encoder, const AVCodec* codec, int preferred)
+{
+    const int* rates = nullptr;
+    int count = 0;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    avcodec_get_supported_config(encoder, codec, AV_CODEC_CONFIG_SAMPLE_RATE, 0,
+                                 reinterpret_cast<const void**>(&rates), &count);
+#else
+    Q_UNUSED(encoder)
+    rates = codec->supported_samplerates;
+    while (rates && rates[count] != 0) count++;
+#endif
+    if (!rates || count == 0) return preferred;
+
+    // Opus only takes 48 kHz and its divisors; pick the closest rate not below the source
+    int best = rates[0];
+    for (int i = 0; i < count; ++i) {
+        if (rates[i] == preferred) return preferred;
+        if (rates[i] >= preferred && (best < preferred || rates[i] < best)) best = rates[i];
+    }
+    return best;
+}
+
+// Stream-level rotation moved from AVStream into AVCodecParameters in FFmpeg 6.1
+int copyDisplayMatrix(const AVStream* input, AVStream* output)
+{
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 31, 100)
+    const AVPacketSideData* matrix = av_packet_side_data_get(input->codecpar->coded_side_data,
+                                                             input->codecpar->nb_coded_side_data,
+                                                             AV_PKT_DATA_DISPLAYMATRIX);
+    if (!matrix) return 0;
+
+    AVPacketSideData* copy = av_packet_side_data_new(&output->codecpar->coded_side_data,
+                                                     &output->codecpar->nb_coded_side_data,
+                                                     AV_PKT_DATA_DISPLAYMATRIX, matrix->size, 0);
+    if (!copy) return AVERROR(ENOMEM);
+    std::memcpy(copy->data, matrix->data, matrix->size);
+#else
+    size_t size = 0;
+    const uint8_t* matrix = av_stream_get_side_data(input, AV_PKT_DATA_DISPLAYMATRIX, &size);
+    if (!matrix) return 0;
+
+    uint8_t* copy = av_stream_new_side_data(output, AV_PKT_DATA_DISPLAYMATRIX, size);
+    if (!copy) return AVERROR(ENOMEM);
+    std::memcpy(copy, matrix, size);
+#endif
+    return 0;
+}
+
+} // namespace
+
+// Every FFmpeg object of one transcode; released in reverse order of creation
+struct TranscodeContext {
+    AVFormatContext* input = nullptr;
+    AVFormatContext* output = nullptr;
+    AVCodecContext* videoDecoder = nullptr;
+    AVCodecContext* videoEncoder = nullptr;
+    AVCodecContext* audioDecoder = nullptr;
+    AVCodecContext* audioEncoder = nullptr;
+    SwrContext* resampler = nullptr;
+    AVAudioFifo* fifo = nullptr;
+    AVFrame* frame = nullptr;
+    AVFrame* scaled = nullptr;
+    AVPacket* packet = nullptr;
+
+    int videoIndex = -1;
+    int audioIndex = -1;
+    AVStream* videoOut = nullptr;
+    AVStream* audioOut = nullptr;
+    int64_t lastVideoPts = AV_NOPTS_VALUE;
+    int64_t audioPts = AV_NOPTS_VALUE;   // encoder time base, seeded by the first decoded frame
+
+    ~TranscodeContext()
+    {
+        av_packet_free(&packet);
+        av_frame_free(&scaled);
+        av_frame_free(&frame);
+        if (fifo) av_audio_fifo_free(fifo);
+        swr_free(&resampler);
+        avcodec_free_context(&audioEncoder);
+        avcodec_free_context(&audioDecoder);
+        avcodec_free_context(&videoEncoder);
+        avcodec_free_context(&videoDecoder);
+        if (output) {
+            if (!(output->oformat->flags & AVFMT_NOFILE)) avio_closep(&output->pb);
+            avformat_free_context(output);
+        }
+        avformat_close_input(&input);
+    }
+};
+
+namespace {
+
+// Drains every packet the encoder has ready into the muxer; frame == nullptr flushes
+int encodeAndWrite(TranscodeContext& ctx, AVCodecContext* encoder, AVStream* stream,
+                   const AVFrame* frame)
+{
+    int ret = avcodec_send_frame(encoder, frame);
+    if (ret < 0 && ret != AVERROR_EOF) return ret;
+
+    AVPacket* packet = av_packet_alloc();
+    while ((ret = avcodec_receive_packet(encoder, packet)) >= 0) {
+        packet->stream_index = stream->index;
+        av_packet_rescale_ts(packet, encoder->time_base, stream->time_base);
+        ret = av_interleaved_write_frame(ctx.output, packet);
+        av_packet_unref(packet);
+        if (ret < 0) break;
+    }
+    av_packet_free(&packet);
+
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) ? 0 : ret;
+}
+
+// Emits whole encoder frames from the FIFO; flush also sends the short tail
+int drainAudioFifo(TranscodeContext& ctx, bool flush)
+{
+    AVCodecContext* encoder = ctx.audioEncoder;
+    int frameSize = encoder->frame_size > 0 ? encoder->frame_size : 1024;
+
+    while (av_audio_fifo_size(ctx.fifo) >= frameSize ||
+           (flush && av_audio_fifo_size(ctx.fifo) > 0)) {
+        int samples = qMin(frameSize, av_audio_fifo_size(ctx.fifo));
+
+        AVFrame* frame = av_frame_alloc();
+        frame->nb_samples = samples;
+        frame->format = encoder->sample_fmt;
+        frame->sample_rate = encoder->sample_rate;
+        av_channel_layout_copy(&frame->ch_layout, &encoder->ch_layout);
+
+        int ret = av_frame_get_buffer(frame, 0);
+        if (ret >= 0) {
+            av_audio_fifo_read(ctx.fifo, reinterpret_cast<void**>(frame->data), samples);
+            if (ctx.audioPts == AV_NOPTS_VALUE) ctx.audioPts = 0;
+            frame->pts = ctx.audioPts;
+            ctx.audioPts += samples;
+            ret = encodeAndWrite(ctx, encoder, ctx.audioOut, frame);
+        }
+        av_frame_free(&frame);
+        if (ret < 0) return ret;
+    }
+    return 0;
+}
+
+int resampleIntoFifo(TranscodeContext& ctx, const AVFrame* frame)
+{
+    AVCodecContext* encoder = ctx.audioEncoder;
+    int outSamples = swr_get_out_samples(ctx.resampler, frame ? frame->nb_samples : 0);
+    if (outSamples <= 0) return 0;
+
+    uint8_t** buffer = nullptr;
+    int ret = av_samples_alloc_array_and_samples(&buffer, nullptr, encoder->ch_layout.nb_channels,
+                                                 outSamples, encoder->sample_fmt, 0);
+    if (ret < 0) return ret;
+
+    int converted = swr_convert(ctx.resampler, buffer, outSamples,
+                                frame ? const_cast<const uint8_t**>(frame->extended_data) : nullptr,
+                                frame ? frame->nb_samples : 0);
+    if (converted > 0) {
+        ret = av_audio_fifo_write(ctx.fifo, reinterpret_cast<void**>(buffer), converted);
+    } else {
+        ret = converted;
+    }
+
+    av_freep(&buffer[0]);
+    av_freep(&buffer);
+    return ret < 0 ? ret : 0;
+}
+
+// Converts to the encoder's pixel format and size when they differ from the decoder's
+const AVFrame* convertVideoFrame(TranscodeContext& ctx, AVFrame* frame)
+{
+    AVCodecContext* encoder = ctx.videoEncoder;
+    if (frame->format == encoder->pix_fmt &&
+        frame->width == encoder->width && frame->height == encoder->height) {
+        return frame;
+    }
+
+    t_scaler.context = sws_getCachedContext(t_scaler.context,
+        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+        encoder->width, encoder->height, encoder->pix_fmt,
+        SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (!t_scaler.context) return nullptr;
+
+    av_frame_unref(ctx.scaled);
+    ctx.scaled->format = encoder->pix_fmt;
+    ctx.scaled->width = encoder->width;
+    ctx.scaled->height = encoder->height;
+    if (av_frame_get_buffer(ctx.scaled, 0) < 0) return nullptr;
+
+    sws_scale(t_scaler.context, frame->data, frame->linesize, 0, frame->height,
+              ctx.scaled->data, ctx.scaled->linesize);
+    av_frame_copy_props(ctx.scaled, frame);
+    return ctx.scaled;
+}
+
+} // namespace
+
+#endif // MEDIAFORGE_LIBAV_TRANSCODE
+
+bool LibavTranscoder::isAvailable()
+{
+#ifdef MEDIAFORGE_LIBAV_TRANSCODE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LibavTranscoder::hasEncoder(const QString& name)
+{
+#ifdef MEDIAFORGE_LIBAV_TRANSCODE
+    return avcodec_find_encoder_by_name(name.toUtf8().constData()) != nullptr;
+#else
+    Q_UNUSED(name)
+    return false;
+#endif
+}
+
+void LibavTranscoder::setProgressCallback(std::function<void(qint64, qint64)> callback)
+{
+    m_progressCallback = callback;
+}
+
+bool LibavTranscoder::transcode(const LibavEncodeOptions& options, Job* job)
+{
+#ifdef MEDIAFORGE_LIBAV_TRANSCODE
+    TranscodeContext ctx;
+    int ret = 0;
+
+    auto fail = [this](const QString& what, int code) {
+        m_lastError = code < 0 ? QString("%1: %2").arg(what, avError(code)) : what;
+        Logger::error(m_lastError);
+        return false;
+    };
+
+    // Input
+    QByteArray inputPath = options.inputPath.toUtf8();
+    if ((ret = avformat_open_input(&ctx.input, inputPath.constData(), nullptr, nullptr)) < 0) {
+        return fail("Cannot open input", ret);
+    }
+    if ((ret = avformat_find_stream_info(ctx.input, nullptr)) < 0) {
+        return fail("Cannot read stream info", ret);
+    }
+
+    ctx.videoIndex = av_find_best_stream(ctx.input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (ctx.videoIndex < 0) {
+        return fail("Input has no video stream", ctx.videoIndex);
+    }
+    if (options.includeAudio) {
+        ctx.audioIndex = av_find_best_stream(ctx.input, AVMEDIA_TYPE_AUDIO, -1, ctx.videoIndex, nullptr, 0);
+    }
+    AVStream* videoIn = ctx.input->streams[ctx.videoIndex];
+
+    // Video decoder
+    const AVCodec* videoDecoder = avcodec_find_decoder(videoIn->codecpar->codec_id);
+    if (!videoDecoder) {
+        return fail("No decoder for the video stream", 0);
+    }
+    ctx.videoDecoder = avcodec_alloc_context3(videoDecoder);
+    if ((ret = avcodec_parameters_to_context(ctx.videoDecoder, videoIn->codecpar)) < 0) {
+        return fail("Cannot configure video decoder", ret);
+    }
+    ctx.videoDecoder->pkt_timebase = videoIn->time_base;
+    ctx.videoDecoder->thread_count = qMax(1, options.threads);
+    if ((ret = avcodec_open2(ctx.videoDecoder, videoDecoder, nullptr)) < 0) {
+        return fail("Cannot open video decoder", ret);
+    }
+
+    // Output container
+    QByteArray outputPath = options.outputPath.toUtf8();
+    if ((ret = avformat_alloc_output_context2(&ctx.output, nullptr, nullptr, outputPath.constData())) < 0) {
+        return fail("Cannot create output container", ret);
+    }
+    bool globalHeader = ctx.output->oformat->flags & AVFMT_GLOBALHEADER;
+
+    // Video encoder
+    const AVCodec* videoEncoder = avcodec_find_encoder_by_name(options.videoEncoder.toUtf8().constData());
+    if (!videoEncoder) {
+        return fail(QString("Encoder %1 is not available").arg(options.videoEncoder), 0);
+    }
+    ctx.videoEncoder = avcodec_alloc_context3(videoEncoder);
+    AVCodecContext* venc = ctx.videoEncoder;
+    venc->width = ctx.videoDecoder->width;
+    venc->height = ctx.videoDecoder->height;
+    venc->sample_aspect_ratio = ctx.videoDecoder->sample_aspect_ratio;
+    venc->pix_fmt = options.pixelFormat.isEmpty()
+        ? ctx.videoDecoder->pix_fmt
+        : av_get_pix_fmt(options.pixelFormat.toUtf8().constData());
+    venc->color_range = ctx.videoDecoder->color_range;
+    venc->color_primaries = ctx.videoDecoder->color_primaries;
+    venc->color_trc = ctx.videoDecoder->color_trc;
+    venc->colorspace = ctx.videoDecoder->colorspace;
+
+    // Source timestamps pass straight through, so VFR input stays VFR
+    venc->time_base = videoIn->time_base;
+    venc->framerate = av_guess_frame_rate(ctx.input, videoIn, nullptr);
+    venc->thread_count = qMax(1, options.threads);
+    if (globalHeader) venc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    AVDictionary* videoOptions = nullptr;
+    for (const auto& option : options.videoOptions) {
+        av_dict_set(&videoOptions, option.first.toUtf8().constData(),
+                    option.second.toUtf8().constData(), 0);
+    }
+    ret = avcodec_open2(venc, videoEncoder, &videoOptions);
+    av_dict_free(&videoOptions);
+    if (ret < 0) {
+        return fail("Cannot open video encoder", ret);
+    }
+
+    ctx.videoOut = avformat_new_stream(ctx.output, nullptr);
+    if ((ret = avcodec_parameters_from_context(ctx.videoOut->codecpar, venc)) < 0) {
+        return fail("Cannot configure video stream", ret);
+    }
+    ctx.videoOut->time_base = venc->time_base;
+    ctx.videoOut->avg_frame_rate = venc->framerate;
+
+    // Frames are encoded as stored; the display matrix keeps phone footage upright,
+    // where the CLI would rotate the pixels instead
+    if ((ret = copyDisplayMatrix(videoIn, ctx.videoOut)) < 0) {
+        return fail("Cannot copy the display matrix", ret);
+    }
+
+    // Audio: copied as-is, or decoded, resampled and re-encoded
+    if (ctx.audioIndex >= 0) {
+        AVStream* audioIn = ctx.input->streams[ctx.audioIndex];
+        ctx.audioOut = avformat_new_stream(ctx.output, nullptr);
+
+        if (options.audioEncoder.isEmpty()) {
+            if ((ret = avcodec_parameters_copy(ctx.audioOut->codecpar, audioIn->codecpar)) < 0) {
+                return fail("Cannot copy audio parameters", ret);
+            }
+            ctx.audioOut->codecpar->codec_tag = 0;
+            ctx.audioOut->time_base = audioIn->time_base;
+        } else {
+            const AVCodec* audioDecoder = avcodec_find_decoder(audioIn->codecpar->codec_id);
+            const AVCodec* audioEncoder = avcodec_find_encoder_by_name(options.audioEncoder.toUtf8().constData());
+            if (!audioDecoder || !audioEncoder) {
+                return fail(QString("Audio codec %1 is not available").arg(options.audioEncoder), 0);
+            }
+
+            ctx.audioDecoder = avcodec_alloc_context3(audioDecoder);
+            if ((ret = avcodec_parameters_to_context(ctx.audioDecoder, audioIn->codecpar)) < 0) {
+                return fail("Cannot configure audio decoder", ret);
+            }
+            ctx.audioDecoder->pkt_timebase = audioIn->time_base;
+            if ((ret = avcodec_open2(ctx.audioDecoder, audioDecoder, nullptr)) < 0) {
+                return fail("Cannot open audio decoder", ret);
+            }
+
+            ctx.audioEncoder = avcodec_alloc_context3(audioEncoder);
+            AVCodecContext* aenc = ctx.audioEncoder;
+            av_channel_layout_copy(&aenc->ch_layout, &ctx.audioDecoder->ch_layout);
+            aenc->sample_rate = pickSampleRate(aenc, audioEncoder, ctx.audioDecoder->sample_rate);
+            aenc->sample_fmt = pickSampleFormat(aenc, audioEncoder, ctx.audioDecoder->sample_fmt);
+            aenc->time_base = AVRational{1, aenc->sample_rate};
+            if (options.audioBitrate > 0) aenc->bit_rate = options.audioBitrate * 1000LL;
+            if (globalHeader) aenc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            if ((ret = avcodec_open2(aenc, audioEncoder, nullptr)) < 0) {
+                return fail("Cannot open audio encoder", ret);
+            }
+
+            if ((ret = avcodec_parameters_from_context(ctx.audioOut->codecpar, aenc)) < 0) {
+                return fail("Cannot configure audio stream", ret);
+            }
+            ctx.audioOut->time_base = aenc->time_base;
+
+            ret = swr_alloc_set_opts2(&ctx.resampler,
+                &aenc->ch_layout, aenc->sample_fmt, aenc->sample_rate,
+                &ctx.audioDecoder->ch_layout, ctx.audioDecoder->sample_fmt, ctx.audioDecoder->sample_rate,
+                0, nullptr);
+            if (ret < 0 || (ret = swr_init(ctx.resampler)) < 0) {
+                return fail("Cannot set up audio resampling", ret);
+            }
+            ctx.fifo = av_audio_fifo_alloc(aenc->sample_fmt, aenc->ch_layout.nb_channels, 1);
+        }
+    }
+
+    av_dict_copy(&ctx.output->metadata, ctx.input->metadata, 0);
+
+    if (!(ctx.output->oformat->flags & AVFMT_NOFILE)) {
+        if ((ret = avio_open(&ctx.output->pb, outputPath.constData(), AVIO_FLAG_WRITE)) < 0) {
+            return fail("Cannot open output file", ret);
+        }
+    }
+    if ((ret = avformat_write_header(ctx.output, nullptr)) < 0) {
+        return fail("Cannot write output header", ret);
+    }
+
+    // Exact frame count when the container has one, otherwise duration x frame rate
+    qint64 totalFrames = videoIn->nb_frames;
+    if (totalFrames <= 0 && ctx.input->duration > 0 && venc->framerate.num > 0) {
+        totalFrames = static_cast<qint64>(ctx.input->duration / double(AV_TIME_BASE) * av_q2d(venc->framerate));
+    }
+    qint64 framesDone = 0;
+
+    ctx.frame = av_frame_alloc();
+    ctx.scaled = av_frame_alloc();
+    ctx.packet = av_packet_alloc();
+
+    auto encodeVideo = [&](AVFrame* frame) -> int {
+        const AVFrame* source = convertVideoFrame(ctx, frame);
+        if (!source) return AVERROR(EINVAL);
+
+        // Encoders reject repeated timestamps; nudge rather than drop the frame
+        AVFrame* out = const_cast<AVFrame*>(source);
+        int64_t pts = frame->best_effort_timestamp;
+        if (pts == AV_NOPTS_VALUE) pts = ctx.lastVideoPts == AV_NOPTS_VALUE ? 0 : ctx.lastVideoPts + 1;
+        if (ctx.lastVideoPts != AV_NOPTS_VALUE && pts <= ctx.lastVideoPts) pts = ctx.lastVideoPts + 1;
+        ctx.lastVideoPts = pts;
+        out->pts = pts;
+        out->pict_type = AV_PICTURE_TYPE_NONE;
+
+        int result = encodeAndWrite(ctx, venc, ctx.videoOut, out);
+        if (m_progressCallback) m_progressCallback(++framesDone, totalFrames);
+        return result;
+    };
+
+    auto decodeVideo = [&](const AVPacket* packet) -> int {
+        int result = avcodec_send_packet(ctx.videoDecoder, packet);
+        if (result < 0 && result != AVERROR_EOF) return result;
+        while ((result = avcodec_receive_frame(ctx.videoDecoder, ctx.frame)) >= 0) {
+            result = encodeVideo(ctx.frame);
+            av_frame_unref(ctx.frame);
+            if (result < 0) return result;
+        }
+        return (result == AVERROR(EAGAIN) || result == AVERROR_EOF) ? 0 : result;
+    };
+
+    auto decodeAudio = [&](const AVPacket* packet) -> int {
+        int result = avcodec_send_packet(ctx.audioDecoder, packet);
+        if (result < 0 && result != AVERROR_EOF) return result;
+        while ((result = avcodec_receive_frame(ctx.audioDecoder, ctx.frame)) >= 0) {
+            // Video keeps the source timestamps, so audio starts where the source's does;
+            // otherwise a non-zero start_time would shift it against the picture
+            if (ctx.audioPts == AV_NOPTS_VALUE && ctx.frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                ctx.audioPts = av_rescale_q(ctx.frame->best_effort_timestamp,
+                                            ctx.input->streams[ctx.audioIndex]->time_base,
+                                            ctx.audioEncoder->time_base);
+            }
+            result = resampleIntoFifo(ctx, ctx.frame);
+            av_frame_unref(ctx.frame);
+            if (result < 0 || (result = drainAudioFifo(ctx, false)) < 0) return result;
+        }
+        return (result == AVERROR(EAGAIN) || result == AVERROR_EOF) ? 0 : result;
+    };
+
+    // Main loop; frames move between decoder, scaler and encoder by reference
+    while ((ret = av_read_frame(ctx.input, ctx.packet)) >= 0) {
+        if (job && job->isCancelRequested()) {
+            m_lastError = "Cancelled";
+            return false;
+        }
+        if (job) job->waitWhilePaused();
+
+        int streamIndex = ctx.packet->stream_index;
+        if (streamIndex == ctx.videoIndex) {
+            ret = decodeVideo(ctx.packet);
+        } else if (streamIndex == ctx.audioIndex && ctx.audioDecoder) {
+            ret = decodeAudio(ctx.packet);
+        } else if (streamIndex == ctx.audioIndex) {
+            av_packet_rescale_ts(ctx.packet, ctx.input->streams[streamIndex]->time_base,
+                                 ctx.audioOut->time_base);
+            ctx.packet->stream_index = ctx.audioOut->index;
+            ctx.packet->pos = -1;
+            ret = av_interleaved_write_frame(ctx.output, ctx.packet);
+        } else {
+            ret = 0;
+        }
+        av_packet_unref(ctx.packet);
+
+        if (ret < 0) {
+            return fail("Transcoding failed", ret);
+        }
+    }
+    if (ret != AVERROR_EOF) {
+        return fail("Reading input failed", ret);
+    }
+
+    // Drain decoders, the resampler and the FIFO, then the encoders
+    if ((ret = decodeVideo(nullptr)) < 0 ||
+        (ret = encodeAndWrite(ctx, venc, ctx.videoOut, nullptr)) < 0) {
+        return fail("Flushing video failed", ret);
+    }
+    if (ctx.audioDecoder) {
+        if ((ret = decodeAudio(nullptr)) < 0 ||
+            (ret = resampleIntoFifo(ctx, nullptr)) < 0 ||
+            (ret = drainAudioFifo(ctx, true)) < 0 ||
+            (ret = encodeAndWrite(ctx, ctx.audioEncoder, ctx.audioOut, nullptr)) < 0) {
+            return fail("Flushing audio failed", ret);
+        }
+    }
+
+    if ((ret = av_write_trailer(ctx.output)) < 0) {
+        return fail("Cannot finalise output", ret);
+    }
+
+    Logger::info(QString("In-process encode finished: %1 frame(s) with %2")
+        .arg(framesDone).arg(options.videoEncoder));
+    return true;
+#else
+    Q_UNUSED(options)
+    Q_UNUSED(job)
+    m_lastError = "Built without FFmpeg libraries";
+    return false;
+#endif
+}
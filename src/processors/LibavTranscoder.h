@@ -0,0 +1,50 @@
+/**
+ * @file LibavTranscoder.h
+ * @brief In-process video transcoder built on the FFmpeg libraries
+ */
+
+#ifndef LIBAVTRANSCODER_H
+#define LIBAVTRANSCODER_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <functional>
+
+class Job;
+
+struct LibavEncodeOptions {
+    QString inputPath;
+    QString outputPath;
+    QString videoEncoder;                          // e.g. "libx265"
+    QList<QPair<QString, QString>> videoOptions;   // encoder AVOptions such as crf, preset
+    QString pixelFormat;                           // empty keeps the decoded format
+    int threads = 1;
+    bool includeAudio = true;
+    QString audioEncoder;                          // empty copies the source audio
+    int audioBitrate = 0;                          // kbit/s, 0 for the encoder default
+};
+
+class LibavTranscoder
+{
+public:
+    LibavTranscoder() = default;
+    ~LibavTranscoder() = default;
+
+    // False when built without FFmpeg or against libraries older than 5.1
+    static bool isAvailable();
+    static bool hasEncoder(const QString& name);
+
+    // Polls the job for cancel and pause between packets
+    bool transcode(const LibavEncodeOptions& options, Job* job);
+    QString lastError() const { return m_lastError; }
+
+    // Frames encoded so far and the expected total (0 when unknown)
+    void setProgressCallback(std::function<void(qint64, qint64)> callback);
+
+private:
+    QString m_lastError;
+    std::function<void(qint64, qint64)> m_progressCallback;
+};
+
+#endif // LIBAVTRANSCODER_H
@@ -0,0 +1,247 @@
+/**
+ * @file SampleEstimator.cpp
+ * @brief Sample estimator implementation
+ */
+
+#include "SampleEstimator.h"
+#include "ImageProcessor.h"
+#include "VideoProcessor.h"
+#include "Job.h"
+#include "MediaInfo.h"
+#include "Logger.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+SampleEstimator& SampleEstimator::instance()
+{
+    static SampleEstimator instance;
+    return instance;
+}
+
+QHash<QString, SampleEstimate> SampleEstimator::estimateBatch(const QStringList& files,
+                                                              const EncodeProfilePtr& profile,
+                                                              const std::function<void(int, int)>& onProgress)
+{
+    m_cancelled = false;
+    
+    QStringList videos;
+    QHash<QString, QStringList> imagesByFormat;
+    for (const QString& file : files) {
+        if (MediaInfo::isVideo(file)) {
+            videos << file;
+        } else if (MediaInfo::isImage(file)) {
+            imagesByFormat[QFileInfo(file).suffix().toLower()] << file;
+        }
+    }
+    
+    // Evenly spaced images per input format stand in for the rest of their format
+    QStringList imageSamples;
+    for (const QStringList& group : std::as_const(imagesByFormat)) {
+        int count = qMin(group.size(), ImageSamplesPerFormat);
+        for (int i = 0; i < count; ++i) {
+            imageSamples << group[static_cast<int>(static_cast<qint64>(group.size()) * i / count)];
+        }
+    }
+    
+    const int total = videos.size() + imageSamples.size();
+    std::atomic<int> done{0};
+    auto step = [&]() {
+        int finished = ++done;
+        if (onProgress) onProgress(finished, total);
+    };
+    
+    // Videos get a few threads each so several sample at once; images run one per core
+    const int cores = qMax(1, QThread::idealThreadCount());
+    QThreadPool videoPool;
+    videoPool.setMaxThreadCount(qMax(1, cores / ThreadsPerVideo));
+    auto videoResults = QtConcurrent::blockingMapped<QList<SampleEstimate>>(&videoPool, videos,
+        [&](const QString& file) {
+            SampleEstimate estimate = estimateVideo(file, profile);
+            step();
+            return estimate;
+        });
+    
+    // Each image sample is timed as core-seconds on one thread, so libvips' process-wide
+    // pool must not fan it out; one sample per core then keeps them from crowding each
+    // other. MainWindow never overlaps a dry run with a batch, and JobQueue::start()
+    // sets the batch's own value
+    ImageProcessor::setConcurrency(1);
+    QThreadPool imagePool;
+    imagePool.setMaxThreadCount(cores);
+    auto imageResults = QtConcurrent::blockingMapped<QList<SampleEstimate>>(&imagePool, imageSamples,
+        [&](const QString& file) {
+            SampleEstimate estimate = estimateImage(file, profile);
+            step();
+            return estimate;
+        });
+    
+    QHash<QString, SampleEstimate> estimates;
+    
+    // Videos that could not be sampled borrow the batch's cost and size per input byte
+    double videoBytes = 0;
+    double videoSeconds = 0;
+    double videoOutput = 0;
+    for (int i = 0; i < videos.size(); ++i) {
+        if (!videoResults[i].sampled) continue;
+        estimates.insert(videos[i], videoResults[i]);
+        videoBytes += QFileInfo(videos[i]).size();
+        videoSeconds += videoResults[i].coreSeconds;
+        videoOutput += videoResults[i].outputSize;
+    }
+    for (const QString& video : std::as_const(videos)) {
+        if (estimates.contains(video) || videoBytes <= 0) continue;
+        qint64 size = QFileInfo(video).size();
+        estimates.insert(video, {static_cast<qint64>(size * videoOutput / videoBytes),
+                                 size * videoSeconds / videoBytes, false});
+    }
+    
+    // Images scale by input size within their format, or across all formats as a fallback
+    QHash<QString, SampleEstimate> sampledImages;
+    for (int i = 0; i < imageSamples.size(); ++i) {
+        if (imageResults[i].sampled) {
+            sampledImages.insert(imageSamples[i], imageResults[i]);
+        }
+    }
+    
+    auto rates = [&sampledImages](const QStringList& group, double& outputPerByte, double& secondsPerByte) {
+        double bytes = 0;
+        double output = 0;
+        double seconds = 0;
+        for (const QString& file : group) {
+            auto it = sampledImages.constFind(file);
+            if (it == sampledImages.constEnd()) continue;
+            bytes += QFileInfo(file).size();
+            output += it->outputSize;
+            seconds += it->coreSeconds;
+        }
+        if (bytes <= 0) return false;
+        outputPerByte = output / bytes;
+        secondsPerByte = seconds / bytes;
+        return true;
+    };
+    
+    double allOutputPerByte = 0;
+    double allSecondsPerByte = 0;
+    bool haveAll = rates(imageSamples, allOutputPerByte, allSecondsPerByte);
+    
+    for (const QStringList& group : std::as_const(imagesByFormat)) {
+        double outputPerByte = allOutputPerByte;
+        double secondsPerByte = allSecondsPerByte;
+        if (!rates(group, outputPerByte, secondsPerByte) && !haveAll) continue;
+        
+        for (const QString& image : group) {
+            auto it = sampledImages.constFind(image);
+            if (it != sampledImages.constEnd()) {
+                estimates.insert(image, *it);
+                continue;
+            }
+            qint64 size = QFileInfo(image).size();
+            estimates.insert(image, {static_cast<qint64>(size * outputPerByte),
+                                     size * secondsPerByte, false});
+        }
+    }
+    
+    if (m_cancelled) {
+        return {};
+    }
+    
+    int sampled = 0;
+    for (const SampleEstimate& estimate : std::as_const(estimates)) {
+        if (estimate.sampled) sampled++;
+    }
+    Logger::info(QString("Dry run: %1 of %2 file(s) sampled, %3 estimated")
+        .arg(sampled).arg(files.size()).arg(estimates.size()));
+    
+    QMutexLocker locker(&m_mutex);
+    m_profile = profile;
+    m_estimates = estimates;
+    return estimates;
+}
+
+SampleEstimate SampleEstimator::estimateVideo(const QString& filePath, const EncodeProfilePtr& profile)
+{
+    SampleEstimate estimate;
+    if (m_cancelled) return estimate;
+    
+    auto job = std::make_shared<Job>(filePath, profile);
+    job->setThreadBudget(ThreadsPerVideo);
+    track(job, true);
+    
+    VideoProcessor processor;
+    estimate.sampled = processor.estimateSamples(job.get(), estimate.outputSize, estimate.coreSeconds);
+    if (!estimate.sampled && !job->isCancelRequested()) {
+        Logger::warning(QString("Could not sample %1: %2").arg(filePath, processor.lastError()));
+    }
+    
+    track(job, false);
+    return estimate;
+}
+
+SampleEstimate SampleEstimator::estimateImage(const QString& filePath, const EncodeProfilePtr& profile)
+{
+    SampleEstimate estimate;
+    if (m_cancelled) return estimate;
+    
+    // Converted for real, into a scratch folder instead of the batch's output folder
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) return estimate;
+    
+    auto sampleProfile = std::make_shared<EncodeProfile>(*profile);
+    sampleProfile->outputFolder = workDir.path();
+    sampleProfile->overwriteOriginal = false;
+    
+    auto job = std::make_shared<Job>(filePath, sampleProfile);
+    job->setThreadBudget(1);
+    track(job, true);
+    
+    ImageProcessor processor;
+    QElapsedTimer timer;
+    timer.start();
+    if (processor.process(job.get())) {
+        estimate.coreSeconds = timer.elapsed() / 1000.0;
+        estimate.outputSize = QFileInfo(job->outputPath()).size();
+        estimate.sampled = true;
+    }
+    
+    track(job, false);
+    return estimate;
+}
+
+void SampleEstimator::track(const std::shared_ptr<Job>& job, bool active)
+{
+    QMutexLocker locker(&m_mutex);
+    if (active) {
+        m_running.append(job);
+    } else {
+        m_running.removeOne(job);
+    }
+}
+
+void SampleEstimator::cancel()
+{
+    m_cancelled = true;
+    
+    QMutexLocker locker(&m_mutex);
+    for (const auto& job : std::as_const(m_running)) {
+        job->requestCancel();
+    }
+}
+
+bool SampleEstimator::lookup(const QString& filePath, const EncodeProfile& profile,
+                             SampleEstimate& estimate) const
+{
+    QMutexLocker locker(&m_mutex);
+    
+    // Estimates only hold for the exact settings snapshot they were measured with
+    if (m_profile.get() != &profile) return false;
+    
+    auto it = m_estimates.constFind(filePath);
+    if (it == m_estimates.constEnd()) return false;
+    estimate = *it;
+    return true;
+}
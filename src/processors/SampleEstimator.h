@@ -0,0 +1,65 @@
+/**
+ * @file SampleEstimator.h
+ * @brief Dry-run output size and time estimates from sample encodes
+ */
+
+#ifndef SAMPLEESTIMATOR_H
+#define SAMPLEESTIMATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "EncodeProfile.h"
+
+class Job;
+
+struct SampleEstimate {
+    qint64 outputSize = 0;
+    double coreSeconds = 0;     // encode time on one core; divide by threads for wall time
+    bool sampled = false;       // measured on this file rather than extrapolated
+};
+
+class SampleEstimator
+{
+public:
+    static SampleEstimator& instance();
+
+    // Blocking. Encodes evenly spaced samples of every video and a few images per input
+    // format in parallel, extrapolates to whole files and the rest of the batch, and keeps
+    // the result for jobs later queued with the same profile snapshot
+    QHash<QString, SampleEstimate> estimateBatch(const QStringList& files, const EncodeProfilePtr& profile,
+                                                 const std::function<void(int done, int total)>& onProgress = nullptr);
+    
+    // Safe from any thread; running sample encodes are killed
+    void cancel();
+    
+    bool lookup(const QString& filePath, const EncodeProfile& profile, SampleEstimate& estimate) const;
+
+private:
+    SampleEstimator() = default;
+    ~SampleEstimator() = default;
+    SampleEstimator(const SampleEstimator&) = delete;
+    SampleEstimator& operator=(const SampleEstimator&) = delete;
+
+    SampleEstimate estimateVideo(const QString& filePath, const EncodeProfilePtr& profile);
+    SampleEstimate estimateImage(const QString& filePath, const EncodeProfilePtr& profile);
+    void track(const std::shared_ptr<Job>& job, bool active);
+
+    static constexpr int ThreadsPerVideo = 4;
+    static constexpr int ImageSamplesPerFormat = 8;
+
+private:
+    mutable QMutex m_mutex;
+    EncodeProfilePtr m_profile;
+    QHash<QString, SampleEstimate> m_estimates;
+    QList<std::shared_ptr<Job>> m_running;
+    std::atomic<bool> m_cancelled{false};
+};
+
+#endif // SAMPLEESTIMATOR_H
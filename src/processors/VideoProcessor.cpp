@@ -4,21 +4,36 @@
  */
 
 #include "VideoProcessor.h"
+#include "LibavTranscoder.h"
+#include "MediaInfo.h"
 #include "Job.h"
-#include "Settings.h"
-#include "GPUDetector.h"
+#include "CapabilityRegistry.h"
+#include "CrfSearchCache.h"
 #include "Logger.h"
+#include "OutputRing.h"
+#include "ProcessUtils.h"
 
 #include <QProcess>
 #include <QRegularExpression>
 #include <QFileInfo>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QVector>
 #include <QCoreApplication>
+#include <limits>
+#include <memory>
+#include <vector>
 
-VideoProcessor::VideoProcessor()
+VideoProcessor::VideoProcessor() = default;
+
+VideoProcessor::~VideoProcessor() = default;
+
+void VideoProcessor::configure(const EncodeProfile& profile)
 {
     // Find FFmpeg
-    // Find FFmpeg
-    QString customPath = Settings::instance().ffmpegPath();
+    QString customPath = profile.ffmpegPath;
     if (!customPath.isEmpty() && QFileInfo::exists(customPath)) {
         m_ffmpegPath = customPath;
     } else {
@@ -32,17 +47,23 @@ VideoProcessor::VideoProcessor()
         }
     }
 
+    // Probed once per ffmpeg build and shared by every job
+    m_capabilities = CapabilityRegistry::instance().ffmpeg(m_ffmpegPath);
+
     // Check for GPU encoders
-    auto& settings = Settings::instance();
-    if (settings.useGpu()) {
-        GPUDetector detector;
-        auto gpuInfo = detector.detect();
-        m_hasNvenc = gpuInfo.hasNvenc && settings.useNvenc();
-        m_hasNvdec = gpuInfo.hasNvdec && settings.useNvdec();
+    if (profile.useGpu) {
+        GPUInfo gpuInfo = CapabilityRegistry::instance().gpuInfo();
+        m_hasNvenc = gpuInfo.hasNvenc && profile.useNvenc;
+        m_hasNvdec = gpuInfo.hasNvdec && profile.useNvdec && m_capabilities->hasHwaccel("cuda");
     }
 }
 
-VideoProcessor::~VideoProcessor() = default;
+bool VideoProcessor::hasEncoder(const QString& name) const
+{
+    // An empty list means the probe could not tell; let ffmpeg decide
+    return !m_capabilities || m_capabilities->encoders.isEmpty() ||
+           m_capabilities->hasEncoder(name);
+}
 
 bool VideoProcessor::process(Job* job)
 {
@@ -51,6 +72,37 @@ bool VideoProcessor::process(Job* job)
         return false;
     }
 
+    configure(job->profile());
+    m_crf = crfFor(job);
+    planStreamCopy(job);
+    
+    // Classified before the path is chosen: both paths apply the same tuning, and only
+    // decimated screen captures need the command line's filter graph
+    planContentTuning(job);
+    bool targetQuality = job->profile().videoCompressionMode == "target_quality";
+
+    // The linked libraries skip the encoder's process spawn; an uncached CRF search
+    // still runs its sample encodes on the command-line path
+    if (canEncodeInProcess(job) && (!targetQuality || cachedTargetCrf(job))) {
+        if (processInProcess(job)) {
+            return true;
+        }
+        if (job->isCancelRequested()) {
+            return false;
+        }
+        Logger::warning(QString("In-process encode failed, retrying with FFmpeg: %1").arg(m_lastError));
+    }
+    
+    // Finds m_crf before the encode starts; falls back to the custom CRF
+    if (targetQuality && !searchTargetCrf(job)) {
+        if (job->isCancelRequested()) {
+            m_lastError = "Cancelled";
+            return false;
+        }
+        m_crf = crfFor(job);
+        Logger::warning(QString("CRF search failed, using CRF %1: %2").arg(m_crf).arg(m_lastError));
+    }
+
     if (!checkFFmpeg()) {
         return false;
     }
@@ -59,85 +111,214 @@ bool VideoProcessor::process(Job* job)
     Logger::info(QString("FFmpeg path: %1").arg(m_ffmpegPath));
     reportProgress(5);
 
-    // Get video duration for progress calculation
-    double totalDuration = 0;
-    {
-        QString ffprobePath = QFileInfo(m_ffmpegPath).absolutePath() + "/ffprobe.exe";
-        QProcess probe;
-        probe.start(ffprobePath, {
-            "-v", "error",
-            "-show_entries", "format=duration",
-            "-of", "default=noprint_wrappers=1:nokey=1",
-            job->inputPath()
-        });
-        
-        if (probe.waitForFinished(10000)) {
-            QString output = probe.readAllStandardOutput().trimmed();
-            totalDuration = output.toDouble();
-            Logger::info(QString("Video duration: %1 seconds").arg(totalDuration));
-        }
+    // Video duration for progress; usually already cached by the scheduler's cost probe.
+    // When ffprobe is unavailable, runFFmpeg() reads it from the encoder's own header.
+    m_duration = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath).duration;
+    Logger::info(QString("Video duration: %1 seconds").arg(m_duration));
+
+    // Safe point before the encoder is spawned
+    job->waitWhilePaused();
+    if (job->isCancelRequested()) {
+        m_lastError = "Cancelled";
+        return false;
     }
 
-    // Build FFmpeg command
-    QStringList args = buildFFmpegArgs(job);
+    // Long videos can be split and encoded side by side
+    int chunks = chunkCountFor(job, m_duration);
+    if (chunks > 1) {
+        return processChunked(job, m_duration, chunks);
+    }
 
-    Logger::info(QString("FFmpeg command: %1 %2")
-        .arg(m_ffmpegPath)
-        .arg(args.join(" ")));
+    // Build FFmpeg command
+    QStringList args = buildFFmpegArgs(job, job->inputPath(), job->outputPath(),
+                                       job->threadBudget(), true);
 
     reportProgress(10);
 
     // Run FFmpeg
-    QProcess process;
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start(m_ffmpegPath, args);
-
-    if (!process.waitForStarted(10000)) {
-        m_lastError = QString("Failed to start FFmpeg: %1").arg(process.errorString());
-        Logger::error(m_lastError);
+    bool ok = runFFmpeg(job, {args}, [this, job](int, const FFmpegProgress& progress) {
+        job->setEncodeRate(progress.fps, progress.speed);
+        if (m_duration > 0) {
+            int percent = static_cast<int>(10 + (progress.outTimeSeconds() / m_duration) * 85);
+            reportProgress(qMin(percent, 95));
+        }
+    });
+    if (!ok) {
         return false;
     }
 
-    // Collect all output
-    QByteArray allOutput;
+    return finishOutput(job);
+}
+
+bool VideoProcessor::estimateSamples(Job* job, qint64& outputSize, double& coreSeconds)
+{
+    configure(job->profile());
+    m_crf = crfFor(job);
+    planStreamCopy(job);
+    planContentTuning(job);
     
-    // Parse progress from FFmpeg output
-    while (process.state() == QProcess::Running) {
-        if (process.waitForReadyRead(100)) {
-            QByteArray data = process.readAll();
-            allOutput.append(data);
-            QString output = QString::fromUtf8(data);
-            
-            // Parse time progress
-            static QRegularExpression timeRegex(R"(time=(\d+):(\d+):(\d+)\.(\d+))");
-            auto match = timeRegex.match(output);
-            
-            if (match.hasMatch() && totalDuration > 0) {
-                int hours = match.captured(1).toInt();
-                int minutes = match.captured(2).toInt();
-                int seconds = match.captured(3).toInt();
-                
-                double currentTime = hours * 3600 + minutes * 60 + seconds;
-                int progress = static_cast<int>(10 + (currentTime / totalDuration) * 85);
-                
-                reportProgress(qMin(progress, 95));
-            }
+    if (!checkFFmpeg()) {
+        return false;
+    }
+    
+    double duration = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath).duration;
+    if (duration <= 0) {
+        m_lastError = "Video duration is unknown";
+        return false;
+    }
+    
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        m_lastError = QString("Cannot create sample directory: %1").arg(workDir.errorString());
+        return false;
+    }
+    
+    // Centred in equal slices of the video; a short video is encoded whole
+    QVector<double> starts;
+    double sampleLength = EstimateSampleSeconds;
+    if (duration > EstimateSamples * EstimateSampleSeconds * 2) {
+        for (int i = 0; i < EstimateSamples; ++i) {
+            starts << duration * (2 * i + 1) / (2 * EstimateSamples) - sampleLength / 2;
         }
+    } else {
+        starts << 0.0;
+        sampleLength = duration;
+    }
+    
+    int parallel = sampleParallelism(job, starts.size());
+    int threads = qMax(1, job->threadBudget() / parallel);
+    QString extension = QFileInfo(job->outputPath()).suffix();
+    QList<QStringList> encodes;
+    QStringList outputs;
+    for (int i = 0; i < starts.size(); ++i) {
+        QString output = workDir.filePath(QString("estimate_%1.%2").arg(i).arg(extension));
+        QStringList args = buildFFmpegArgs(job, job->inputPath(), output, threads, true);
+        
+        // Seek on the input and cut the output, which buildFFmpegArgs() puts last
+        int input = args.indexOf("-i");
+        args.insert(input, QString::number(starts[i], 'f', 3));
+        args.insert(input, "-ss");
+        args.insert(args.size() - 1, "-t");
+        args.insert(args.size() - 1, QString::number(sampleLength, 'f', 3));
+        
+        encodes << args;
+        outputs << output;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    if (!runFFmpegBatched(job, encodes, parallel)) {
+        return false;
     }
+    double wallSeconds = timer.elapsed() / 1000.0;
+    
+    qint64 sampledBytes = 0;
+    for (const QString& output : std::as_const(outputs)) {
+        sampledBytes += QFileInfo(output).size();
+    }
+    if (sampledBytes <= 0) {
+        m_lastError = "Sample encodes produced no output";
+        return false;
+    }
+    
+    // Process startup is included, which slightly overstates very short videos
+    double scale = duration / (starts.size() * sampleLength);
+    outputSize = static_cast<qint64>(sampledBytes * scale);
+    coreSeconds = wallSeconds * threads * parallel * scale;
+    return true;
+}
 
-    // Get any remaining output
-    allOutput.append(process.readAll());
-    process.waitForFinished(-1);
+bool VideoProcessor::canEncodeInProcess(Job* job) const
+{
+    const EncodeProfile& profile = job->profile();
+    if (!profile.inProcessVideo || !LibavTranscoder::isAvailable()) {
+        return false;
+    }
+    
+    // Chunking, stream copy, frame decimation and NVENC (with CUDA decode) stay on the CLI path
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
+    return !profile.chunkedEncode && codec != "copy" && !useNvencEncoder && !m_copyVideo &&
+           m_contentClass != ContentClass::Screen;
+}
 
-    if (process.exitCode() != 0) {
-        QString outputStr = QString::fromUtf8(allOutput);
-        m_lastError = QString("FFmpeg failed (exit code %1): %2")
-            .arg(process.exitCode())
-            .arg(outputStr.right(500));  // Last 500 chars
-        Logger::error(m_lastError);
+bool VideoProcessor::processInProcess(Job* job)
+{
+    const EncodeProfile& profile = job->profile();
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
+    
+    LibavEncodeOptions options;
+    options.inputPath = job->inputPath();
+    options.outputPath = job->outputPath();
+    options.videoEncoder = encoderFor(codec, false);
+    options.pixelFormat = "yuv420p";  // Standard 8-bit for compatibility
+    options.threads = qMax(1, job->threadBudget());
+    
+    if (!LibavTranscoder::hasEncoder(options.videoEncoder)) {
+        m_lastError = QString("Encoder %1 is not in the linked FFmpeg libraries").arg(options.videoEncoder);
+        return false;
+    }
+    
+    // Same quality and thread settings the CLI path passes as arguments
+    QString threads = QString::number(options.threads);
+    options.videoOptions << qMakePair(QString("crf"), QString::number(m_crf));
+    if (options.videoEncoder == "libvpx-vp9") {
+        options.videoOptions << qMakePair(QString("b"), QString("0"));
+        options.videoOptions << qMakePair(QString("row-mt"), QString("1"));
+    } else if (options.videoEncoder == "libsvtav1") {
+        options.videoOptions << qMakePair(QString("preset"), QString::number(svtAv1Preset(profile)));
+        options.videoOptions << qMakePair(QString("svtav1-params"), svtAv1Params(job, options.threads));
+    } else if (options.videoEncoder == "libaom-av1") {
+        options.videoOptions << qMakePair(QString("b"), QString("0"));
+        options.videoOptions << qMakePair(QString("cpu-used"), QString::number(aomCpuUsed(profile)));
+        if (profile.videoCompressionMode == "lossless") {
+            options.videoOptions << qMakePair(QString("lossless"), QString("1"));
+        }
+        options.videoOptions << qMakePair(QString("row-mt"), QString("1"));
+    } else {
+        options.videoOptions << qMakePair(QString("preset"), profile.videoPreset);
+    }
+    if (options.videoEncoder == "libx265") {
+        options.videoOptions << qMakePair(QString("x265-params"), QString("pools=%1").arg(threads));
+    }
+    options.videoOptions << contentOptions(options.videoEncoder);
+    
+    options.includeAudio = profile.preserveAudio;
+    if (profile.audioCodec != "copy" && !m_copyAudio) {
+        options.audioEncoder = getAudioEncoder(profile);
+        if (options.audioEncoder != "flac") {
+            options.audioBitrate = profile.audioBitrate;
+        }
+    }
+    
+    Logger::info(QString("In-process encode with %1 (%2 threads)").arg(options.videoEncoder, threads));
+    reportProgress(10);
+    
+    // Exact frame counts; only forward whole-percent changes
+    int lastProgress = -1;
+    LibavTranscoder transcoder;
+    transcoder.setProgressCallback([this, &lastProgress](qint64 done, qint64 total) {
+        if (total <= 0) return;
+        int progress = qMin(95, static_cast<int>(10 + done * 85 / total));
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            reportProgress(progress);
+        }
+    });
+    
+    if (!transcoder.transcode(options, job)) {
+        m_lastError = transcoder.lastError();
         return false;
     }
+    
+    return finishOutput(job);
+}
 
+bool VideoProcessor::finishOutput(Job* job)
+{
     // Update job with output size
     QFileInfo outputInfo(job->outputPath());
     if (outputInfo.exists() && outputInfo.size() > 0) {
@@ -153,6 +334,829 @@ bool VideoProcessor::process(Job* job)
     return false;
 }
 
+bool VideoProcessor::runFFmpeg(Job* job, const QList<QStringList>& invocations,
+                               const std::function<void(int, const FFmpegProgress&)>& onProgress,
+                               QStringList* logTails)
+{
+    std::vector<std::unique_ptr<QProcess>> processes;
+    auto killAll = [&processes]() {
+        for (auto& process : processes) {
+            ProcessUtils::kill(*process);
+        }
+    };
+    
+    for (const QStringList& invocation : invocations) {
+        // Progress comes as key=value blocks on stdout; stderr only carries the log
+        QStringList args = {"-nostats", "-progress", "pipe:1"};
+        args << invocation;
+        
+        Logger::info(QString("FFmpeg command: %1 %2")
+            .arg(m_ffmpegPath)
+            .arg(args.join(" ")));
+        
+        auto process = std::make_unique<QProcess>();
+        process->setProcessChannelMode(QProcess::SeparateChannels);
+        process->setReadChannel(QProcess::StandardOutput);
+        ProcessUtils::prepare(*process);
+        process->start(m_ffmpegPath, args);
+
+        if (!process->waitForStarted(10000)) {
+            m_lastError = QString("Failed to start FFmpeg: %1").arg(process->errorString());
+            Logger::error(m_lastError);
+            killAll();
+            return false;
+        }
+        processes.push_back(std::move(process));
+    }
+
+    // Keep the log tail for error reports; progress is parsed in place
+    const int count = static_cast<int>(processes.size());
+    std::vector<OutputRing> logs(count);
+    std::vector<FFmpegProgressParser> parsers(count);
+    QVector<bool> suspended(count, false);
+    QVector<bool> finished(count, false);
+    
+    // Without a probed duration, the encoder's log header supplies it; only passes that
+    // report progress need it, and only until that header has been read once
+    QVector<bool> headerRead(count, m_duration > 0 || !onProgress);
+    QVector<qint64> headerBytes(count, 0);
+    const int sliceMs = qMax(1, ProcessUtils::PollIntervalMs / qMax(1, count));
+    char buffer[4096];
+    
+    auto drain = [&](int i) {
+        QProcess& process = *processes[i];
+        qint64 read = 0;
+        bool progressed = false;
+        while ((read = process.read(buffer, sizeof(buffer))) > 0) {
+            progressed |= parsers[i].feed(buffer, read);
+        }
+        ProcessUtils::drain(process, QProcess::StandardError, logs[i]);
+        
+        // Rescanned only when new log bytes arrived; "Stream mapping:" closes the input
+        // section, and a wrapped ring has already lost it
+        if (!headerRead[i] && m_duration <= 0 && logs[i].totalBytes() != headerBytes[i]) {
+            static const QRegularExpression durationRegex(R"(Duration: (\d+):(\d+):(\d+(?:\.\d+)?))");
+            headerBytes[i] = logs[i].totalBytes();
+            QString header = logs[i].text();
+            auto match = durationRegex.match(header);
+            if (match.hasMatch()) {
+                m_duration = match.captured(1).toInt() * 3600 +
+                             match.captured(2).toInt() * 60 +
+                             match.captured(3).toDouble();
+            }
+            headerRead[i] = match.hasMatch() || logs[i].wrapped() || header.contains("Stream mapping:");
+        }
+        
+        if (progressed && onProgress) {
+            onProgress(i, parsers[i].current());
+        }
+    };
+    
+    bool running = true;
+    while (running) {
+        if (job->isCancelRequested()) {
+            killAll();
+            m_lastError = "Cancelled";
+            Logger::info(QString("Video encode cancelled: %1").arg(job->inputPath()));
+            return false;
+        }
+        
+        running = false;
+        for (int i = 0; i < count; ++i) {
+            if (finished[i]) continue;
+            QProcess& process = *processes[i];
+            
+            if (process.state() == QProcess::Running) {
+                running = true;
+                
+                // Pause freezes the encoder in place; resume continues the same frame
+                ProcessUtils::syncSuspended(process, job->isPauseRequested(), suspended[i]);
+                
+                process.waitForReadyRead(sliceMs);
+                drain(i);
+                continue;
+            }
+            
+            // Get any remaining output
+            process.waitForFinished(-1);
+            drain(i);
+            finished[i] = true;
+            
+            // One failed piece fails the whole set, so the others are stopped right away
+            if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+                QString outputStr = logs[i].text();
+                m_lastError = QString("FFmpeg failed (exit code %1): %2")
+                    .arg(process.exitCode())
+                    .arg(outputStr.right(500));  // Last 500 chars
+                Logger::error(m_lastError);
+                killAll();
+                return false;
+            }
+        }
+    }
+    
+    if (logTails) {
+        logTails->clear();
+        for (const OutputRing& log : logs) {
+            *logTails << log.text();
+        }
+    }
+    
+    return true;
+}
+
+bool VideoProcessor::runFFmpegBatched(Job* job, const QList<QStringList>& invocations,
+                                      int maxParallel, QStringList* logTails)
+{
+    if (logTails) logTails->clear();
+    
+    int width = qMax(1, maxParallel);
+    for (int first = 0; first < invocations.size(); first += width) {
+        QStringList tails;
+        if (!runFFmpeg(job, invocations.mid(first, width), nullptr, logTails ? &tails : nullptr)) {
+            return false;
+        }
+        if (logTails) *logTails << tails;
+    }
+    return true;
+}
+
+int VideoProcessor::sampleParallelism(Job* job, int count)
+{
+    // One process per granted thread at most, so sample passes respect the CPU budget
+    return qBound(1, job->threadBudget(), qMax(1, count));
+}
+
+void VideoProcessor::planStreamCopy(Job* job)
+{
+    m_copyVideo = false;
+    m_copyAudio = false;
+    
+    const EncodeProfile& profile = job->profile();
+    if (!profile.smartStreamCopy) {
+        return;
+    }
+    
+    // Usually a cache hit; the scheduler probed the file for its cost estimate
+    VideoInfo info = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath);
+    if (info.videoCodec.isEmpty()) {
+        return;
+    }
+    
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
+    
+    // Same codec and the same 8-bit 4:2:0 layout our encodes produce
+    if (codec != "copy" && info.videoCodec == codec &&
+        (info.pixelFormat == "yuv420p" || info.pixelFormat == "yuvj420p") &&
+        info.width > 0 && info.height > 0) {
+        // MKV and WebM only record the overall rate; counting the audio in errs towards encoding
+        int64_t videoBitrate = info.videoBitrate > 0 ? info.videoBitrate : info.bitrate - info.audioBitrate;
+        double fps = info.fps > 0 ? info.fps : 30.0;
+        double bitsPerPixel = videoBitrate / (static_cast<double>(info.width) * info.height * fps);
+        m_copyVideo = videoBitrate > 0 &&
+                      bitsPerPixel <= maxBitsPerPixel(codec, profile.videoCompressionMode);
+    }
+    
+    // Same audio codec at no more than the target bitrate, with headroom for VBR estimates
+    if (profile.preserveAudio && profile.audioCodec != "copy" && info.audioCodec == profile.audioCodec) {
+        m_copyAudio = profile.audioCodec == "flac" ||
+                      (info.audioBitrate > 0 && info.audioBitrate <= profile.audioBitrate * 1250LL);
+    }
+    
+    if (m_copyVideo || m_copyAudio) {
+        Logger::info(QString("Stream copy for %1: video %2, audio %3")
+            .arg(job->inputPath())
+            .arg(m_copyVideo ? "copied" : "re-encoded")
+            .arg(m_copyAudio ? "copied" : "re-encoded"));
+    }
+}
+
+double VideoProcessor::maxBitsPerPixel(const QString& codec, const QString& compressionMode)
+{
+    // Copying never loses quality, so a lossless target accepts any bitrate
+    if (compressionMode == "lossless") {
+        return std::numeric_limits<double>::infinity();
+    }
+    
+    // Roughly what each encoder spends per pixel at CRF 23 on typical footage
+    double base = 0.10;
+    if (codec == "hevc" || codec == "vp9") {
+        base = 0.07;
+    } else if (codec == "av1") {
+        base = 0.05;
+    }
+    
+    if (compressionMode == "visually_lossless") {
+        return base * 2.0;
+    } else if (compressionMode == "medium") {
+        return base * 0.6;
+    } else if (compressionMode == "web") {
+        return base * 0.4;
+    }
+    return base;
+}
+
+bool VideoProcessor::searchTargetCrf(Job* job)
+{
+    const EncodeProfile& profile = job->profile();
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
+    if (codec == "copy" || m_copyVideo) {
+        return true;
+    }
+    
+    if (!m_capabilities || !m_capabilities->usable) {
+        m_lastError = "CRF search needs the FFmpeg command line tool";
+        return false;
+    }
+    
+    // libvmaf is an optional build dependency; ssim and psnr are always built in
+    QString metric = profile.videoQualityMetric;
+    QString filter = metric == "vmaf" ? QString("libvmaf") : metric;
+    if (filter != "libvmaf" && filter != "ssim" && filter != "psnr") {
+        m_lastError = QString("Unknown quality metric: %1").arg(metric);
+        return false;
+    }
+    if (!m_capabilities->filters.isEmpty() && !m_capabilities->hasFilter(filter)) {
+        m_lastError = QString("This FFmpeg build has no %1 filter").arg(filter);
+        return false;
+    }
+    
+    QString encoder = encoderFor(codec, useNvencEncoder);
+    QString setup = crfSearchSetup(job);
+    if (cachedTargetCrf(job)) {
+        return true;
+    }
+    
+    // Useful quality range of each encoder's CRF scale
+    int low = 16;
+    int high = 40;
+    if (encoder == "libvpx-vp9") {
+        low = 15;
+        high = 50;
+    } else if (encoder == "libsvtav1" || encoder == "libaom-av1") {
+        low = 20;
+        high = 55;
+    }
+    
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        m_lastError = QString("Cannot create sample directory: %1").arg(workDir.errorString());
+        return false;
+    }
+    
+    // Evenly spaced samples away from intros and credits; short videos are one sample
+    double duration = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath).duration;
+    QVector<double> starts;
+    double sampleLength = SampleSeconds;
+    if (duration >= SearchSamples * SampleSeconds * 2) {
+        for (int i = 0; i < SearchSamples; ++i) {
+            starts << duration * (i + 1) / (SearchSamples + 1) - SampleSeconds / 2;
+        }
+    } else {
+        starts << 0.0;
+        sampleLength = SearchSamples * SampleSeconds;
+    }
+    
+    Logger::info(QString("CRF search (%1 >= %2) over %3 sample(s) of %4")
+        .arg(metric).arg(profile.videoTargetQuality).arg(starts.size()).arg(job->inputPath()));
+    
+    // Lossless references in the encode's pixel format, so scores compare like with like
+    int budget = qMax(1, job->threadBudget());
+    QStringList references;
+    QList<QStringList> extracts;
+    for (int i = 0; i < starts.size(); ++i) {
+        QString reference = workDir.filePath(QString("reference_%1.mkv").arg(i));
+        QStringList extract{
+            "-y", "-hide_banner", "-loglevel", "error",
+            "-ss", QString::number(starts[i], 'f', 3), "-i", job->inputPath(),
+            "-t", QString::number(sampleLength, 'f', 3),
+            "-map", "0:v:0", "-an",
+            "-threads", QString::number(qMax(1, budget / sampleParallelism(job, starts.size()))),
+            "-c:v", "ffv1", "-pix_fmt", "yuv420p"
+        };
+        
+        // Decimated like the final encode, so scores compare the frames it keeps;
+        // decimating the samples again then drops little if anything
+        if (m_contentClass == ContentClass::Screen) {
+            extract << "-vf" << "mpdecimate" << vfrOption() << "vfr";
+        }
+        extracts << (extract << reference);
+        references << reference;
+    }
+    if (!runFFmpegBatched(job, extracts, sampleParallelism(job, extracts.size()))) {
+        return false;
+    }
+    
+    // Quality falls as CRF rises: everything below `low` passed, everything above `high` failed
+    int best = -1;
+    for (int round = 0; round < MaxSearchRounds && low <= high; ++round) {
+        QVector<int> candidates;
+        int span = high - low + 1;
+        for (int i = 1; i <= CandidatesPerRound; ++i) {
+            int crf = span <= CandidatesPerRound ? low + i - 1 : low + span * i / (CandidatesPerRound + 1);
+            if (crf <= high && !candidates.contains(crf)) {
+                candidates << crf;
+            }
+        }
+        
+        // Every sample at every candidate, no more at once than the job has threads
+        int parallel = sampleParallelism(job, candidates.size() * references.size());
+        int threads = qMax(1, budget / parallel);
+        QList<QStringList> encodes;
+        QList<QStringList> scores;
+        for (int c = 0; c < candidates.size(); ++c) {
+            m_crf = candidates[c];
+            for (int s = 0; s < references.size(); ++s) {
+                QString encoded = workDir.filePath(QString("sample_%1_crf%2.mkv").arg(s).arg(m_crf));
+                encodes << buildFFmpegArgs(job, references[s], encoded, threads, false);
+                
+                // libvmaf takes the distorted clip first
+                QString lavfi = QString("[0:v][1:v]%1").arg(filter);
+                if (filter == "libvmaf") {
+                    lavfi += QString("=n_threads=%1").arg(threads);
+                }
+                scores << QStringList{
+                    "-hide_banner", "-loglevel", "info",
+                    "-i", encoded, "-i", references[s],
+                    "-lavfi", lavfi, "-f", "null", "-"
+                };
+            }
+        }
+        
+        QStringList logs;
+        if (!runFFmpegBatched(job, encodes, parallel) ||
+            !runFFmpegBatched(job, scores, parallel, &logs)) {
+            return false;
+        }
+        
+        for (int c = 0; c < candidates.size(); ++c) {
+            double total = 0;
+            for (int s = 0; s < references.size(); ++s) {
+                double score = 0;
+                if (!parseQualityScore(metric, logs[c * references.size() + s], score)) {
+                    m_lastError = QString("No %1 score in the FFmpeg output").arg(metric);
+                    return false;
+                }
+                total += score;
+            }
+            
+            double mean = total / references.size();
+            Logger::info(QString("CRF %1: %2 %3").arg(candidates[c]).arg(metric).arg(mean, 0, 'f', 4));
+            if (mean >= profile.videoTargetQuality) {
+                best = qMax(best, candidates[c]);
+                low = qMax(low, candidates[c] + 1);
+            } else {
+                high = qMin(high, candidates[c] - 1);
+            }
+        }
+    }
+    
+    // Nothing in range reached the target: take the best quality the range offers
+    if (best < 0) {
+        best = low;
+    }
+    
+    m_crf = best;
+    CrfSearchCache::instance().store(job->inputPath(), setup, m_crf);
+    Logger::info(QString("CRF search picked %1 for %2").arg(m_crf).arg(job->inputPath()));
+    return true;
+}
+
+QString VideoProcessor::crfSearchSetup(Job* job) const
+{
+    const EncodeProfile& profile = job->profile();
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString encoder = encoderFor(resolveCodec(profile, outputExt, useNvencEncoder), useNvencEncoder);
+    return QString("%1|%2|%3|%4|%5").arg(encoder, profile.videoPreset, profile.videoQualityMetric)
+        .arg(profile.videoTargetQuality).arg(contentClassName(m_contentClass));
+}
+
+bool VideoProcessor::cachedTargetCrf(Job* job)
+{
+    int cached = CrfSearchCache::instance().lookup(job->inputPath(), crfSearchSetup(job));
+    if (cached < 0) {
+        return false;
+    }
+    
+    m_crf = cached;
+    Logger::info(QString("Cached CRF %1 for %2").arg(m_crf).arg(job->inputPath()));
+    return true;
+}
+
+bool VideoProcessor::parseQualityScore(const QString& metric, const QString& log, double& score)
+{
+    // Summary lines the filters print when the stream ends
+    static const QRegularExpression vmafRegex(R"(VMAF score[:=]\s*([\d.]+))");
+    static const QRegularExpression ssimRegex(R"(SSIM .*All:([\d.]+))");
+    static const QRegularExpression psnrRegex(R"(PSNR .*average:([\d.]+|inf))");
+    
+    const QRegularExpression& regex = metric == "ssim" ? ssimRegex
+                                    : metric == "psnr" ? psnrRegex : vmafRegex;
+    
+    // The last match is the summary for the whole clip
+    QRegularExpressionMatch last;
+    auto matches = regex.globalMatch(log);
+    while (matches.hasNext()) {
+        last = matches.next();
+    }
+    if (!last.hasMatch()) {
+        return false;
+    }
+    
+    // Identical frames give infinite PSNR
+    score = last.captured(1) == "inf" ? 100.0 : last.captured(1).toDouble();
+    return true;
+}
+
+void VideoProcessor::planContentTuning(Job* job)
+{
+    m_contentClass = ContentClass::Camera;
+    
+    const EncodeProfile& profile = job->profile();
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
+    if (!profile.contentTuning || codec == "copy" || m_copyVideo) {
+        return;
+    }
+    
+    // The analysis runs through the command line tool and a few stock filters
+    static const QStringList requiredFilters = {"hqdn3d", "psnr", "signalstats", "entropy", "mpdecimate"};
+    if (!m_capabilities || !m_capabilities->usable) {
+        return;
+    }
+    for (const QString& filter : requiredFilters) {
+        if (!m_capabilities->filters.isEmpty() && !m_capabilities->hasFilter(filter)) {
+            Logger::info(QString("No %1 filter in this FFmpeg build; content tuning is off").arg(filter));
+            return;
+        }
+    }
+    
+    ContentStats stats;
+    if (!analyzeContent(job, stats)) {
+        if (!job->isCancelRequested()) {
+            Logger::warning(QString("Content analysis failed, encoding without tuning: %1").arg(m_lastError));
+        }
+        return;
+    }
+    
+    m_contentClass = classifyContent(stats);
+    Logger::info(QString("Content of %1: %2 (motion %3, %4% repeated frames, noise %5, entropy %6)")
+        .arg(job->inputPath(), contentClassName(m_contentClass))
+        .arg(stats.motion, 0, 'f', 2)
+        .arg(stats.duplicateFraction * 100, 0, 'f', 0)
+        .arg(stats.noise, 0, 'f', 2)
+        .arg(stats.entropy, 0, 'f', 3));
+}
+
+bool VideoProcessor::analyzeContent(Job* job, ContentStats& stats)
+{
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        m_lastError = QString("Cannot create analysis directory: %1").arg(workDir.errorString());
+        return false;
+    }
+    
+    // Short samples centred in equal slices of the video; a short video is read from the start
+    double duration = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath).duration;
+    QVector<double> starts;
+    double sampleLength = AnalysisSampleSeconds;
+    if (duration > AnalysisSamples * AnalysisSampleSeconds * 2) {
+        for (int i = 0; i < AnalysisSamples; ++i) {
+            starts << duration * (2 * i + 1) / (2 * AnalysisSamples) - sampleLength / 2;
+        }
+    } else {
+        starts << 0.0;
+        sampleLength = AnalysisSamples * AnalysisSampleSeconds;
+    }
+    
+    // Noise is measured at full resolution, where grain lives; motion, repeats and
+    // flatness on a small copy. The metadata filter writes every frame's values to a
+    // file, escaped for the filter graph
+    int parallel = sampleParallelism(job, starts.size());
+    int threads = qMax(1, job->threadBudget() / parallel);
+    QList<QStringList> passes;
+    QStringList statsFiles;
+    for (int i = 0; i < starts.size(); ++i) {
+        QString statsFile = workDir.filePath(QString("stats_%1.txt").arg(i));
+        QString graph = QString("format=yuv420p,split[a][b];[b]hqdn3d=4:3:0:0[c];[a][c]psnr,"
+                                "scale='min(%1,iw)':-2,signalstats,entropy,"
+                                "metadata=mode=print:file='%2'")
+            .arg(AnalysisMaxWidth).arg(QString(statsFile).replace(":", "\\:"));
+        passes << QStringList{
+            "-hide_banner", "-loglevel", "error",
+            "-ss", QString::number(starts[i], 'f', 3), "-i", job->inputPath(),
+            "-t", QString::number(sampleLength, 'f', 3),
+            "-map", "0:v:0", "-an",
+            "-threads", QString::number(threads),
+            "-vf", graph, "-f", "null", "-"
+        };
+        statsFiles << statsFile;
+    }
+    if (!runFFmpegBatched(job, passes, parallel)) {
+        return false;
+    }
+    
+    // Each frame is a "frame:N pts:..." line followed by its key=value lines; the first
+    // frame of a sample has no predecessor, so its YDIF is skipped
+    int compared = 0;
+    int repeated = 0;
+    double motion = 0;
+    double noise = 0;
+    double entropy = 0;
+    for (const QString& statsFile : std::as_const(statsFiles)) {
+        QFile file(statsFile);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        
+        int frameIndex = -1;
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            if (line.startsWith("frame:")) {
+                ++frameIndex;
+                ++stats.frames;
+                continue;
+            }
+            
+            int separator = line.indexOf('=');
+            if (separator < 0) continue;
+            QByteArray key = line.left(separator);
+            double value = line.mid(separator + 1).toDouble();
+            if (key == "lavfi.signalstats.YDIF" && frameIndex > 0) {
+                ++compared;
+                motion += value;
+                if (value < DuplicateMotion) ++repeated;
+            } else if (key == "lavfi.psnr.mse.y") {
+                noise += value;
+            } else if (key == "lavfi.entropy.normalized_entropy.normal.Y") {
+                entropy += value;
+            }
+        }
+    }
+    
+    if (stats.frames == 0) {
+        m_lastError = "Content analysis read no frames";
+        return false;
+    }
+    
+    stats.duplicateFraction = compared > 0 ? static_cast<double>(repeated) / compared : 0;
+    stats.motion = compared > 0 ? motion / compared : 0;
+    stats.noise = noise / stats.frames;
+    stats.entropy = entropy / stats.frames;
+    return true;
+}
+
+VideoProcessor::ContentClass VideoProcessor::classifyContent(const ContentStats& stats)
+{
+    // Mostly repeated frames and little change in the rest; animation drawn on twos
+    // repeats half its frames too, but moves far more between drawings
+    if (stats.duplicateFraction >= ScreenDuplicateFraction && stats.motion < ScreenMaxMotion) {
+        return ContentClass::Screen;
+    }
+    
+    if (stats.noise >= GrainNoise) {
+        return ContentClass::Grain;
+    }
+    
+    // Clean, with few distinct levels: cel animation and motion graphics
+    if (stats.noise < CleanNoise && stats.entropy < FlatEntropy) {
+        return ContentClass::Animation;
+    }
+    
+    return ContentClass::Camera;
+}
+
+QString VideoProcessor::contentClassName(ContentClass contentClass)
+{
+    switch (contentClass) {
+        case ContentClass::Grain:
+            return "grain";
+        case ContentClass::Animation:
+            return "animation";
+        case ContentClass::Screen:
+            return "screen";
+        case ContentClass::Camera:
+            break;
+    }
+    return "camera";
+}
+
+QList<QPair<QString, QString>> VideoProcessor::contentOptions(const QString& encoder) const
+{
+    QList<QPair<QString, QString>> options;
+    
+    // x264 and x265 share tune names; neither has one for screen content.
+    // SVT-AV1 tuning travels in svtAv1Params()
+    if (encoder == "libx264" || encoder == "libx265") {
+        if (m_contentClass == ContentClass::Animation) {
+            options << qMakePair(QString("tune"), QString("animation"));
+        } else if (m_contentClass == ContentClass::Grain) {
+            options << qMakePair(QString("tune"), QString("grain"));
+        }
+    } else if (encoder == "libvpx-vp9") {
+        if (m_contentClass == ContentClass::Screen) {
+            options << qMakePair(QString("tune-content"), QString("screen"));
+        } else if (m_contentClass == ContentClass::Grain) {
+            options << qMakePair(QString("tune-content"), QString("film"));
+        }
+    } else if (encoder == "libaom-av1" && m_contentClass == ContentClass::Grain) {
+        // Denoise before encoding and resynthesise the grain in the decoder
+        options << qMakePair(QString("denoise-noise-level"), QString::number(Av1FilmGrain));
+    }
+    
+    return options;
+}
+
+QString VideoProcessor::vfrOption() const
+{
+    // -fps_mode replaced -vsync in FFmpeg 5.1; git builds carry no release number
+    static const QRegularExpression versionRegex(R"(version n?(\d+)\.(\d+))");
+    QRegularExpressionMatch match = versionRegex.match(m_capabilities ? m_capabilities->version : QString());
+    if (match.hasMatch()) {
+        int major = match.captured(1).toInt();
+        int minor = match.captured(2).toInt();
+        if (major < 5 || (major == 5 && minor < 1)) {
+            return "-vsync";
+        }
+    }
+    return "-fps_mode";
+}
+
+int VideoProcessor::chunkCountFor(Job* job, double totalDuration) const
+{
+    const EncodeProfile& profile = job->profile();
+    if (!profile.chunkedEncode || totalDuration < 2 * MinChunkSeconds) {
+        return 1;
+    }
+    
+    // Stream copy has nothing to parallelise, and NVENC sessions are few and already fast
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    if (m_copyVideo || resolveCodec(profile, outputExt, useNvencEncoder) == "copy" || useNvencEncoder) {
+        return 1;
+    }
+    
+    int chunks = profile.videoChunkCount;
+    if (chunks <= 0) {
+        // Encoders stop scaling well past a few threads, so more pieces beat a wider encoder.
+        // Sized for the whole machine: the queue widens the grant as other jobs finish
+        int reachable = qMax(job->threadBudget(), QThread::idealThreadCount());
+        chunks = qBound(1, reachable / ThreadsPerChunk, MaxAutoChunks);
+    }
+    
+    // Keep pieces long enough that process startup and GOP restarts stay negligible
+    chunks = qMin(chunks, static_cast<int>(totalDuration / MinChunkSeconds));
+    return qMax(1, chunks);
+}
+
+bool VideoProcessor::processChunked(Job* job, double totalDuration, int chunks)
+{
+    const EncodeProfile& profile = job->profile();
+    
+    // Next to the output, so the pieces land on the same disk as the result
+    QTemporaryDir workDir(QFileInfo(job->outputPath()).absolutePath() + "/.dfc-chunks-XXXXXX");
+    if (!workDir.isValid()) {
+        m_lastError = QString("Cannot create chunk directory: %1").arg(workDir.errorString());
+        Logger::error(m_lastError);
+        return false;
+    }
+    
+    Logger::info(QString("Chunked encode: %1 piece(s) of %2").arg(chunks).arg(job->inputPath()));
+    reportProgress(10);
+    
+    // Split the video stream without re-encoding; the segment muxer only cuts on keyframes
+    QStringList cutTimes;
+    for (int i = 1; i < chunks; ++i) {
+        cutTimes << QString::number(totalDuration * i / chunks, 'f', 3);
+    }
+    
+    QString segmentList = workDir.filePath("segments.csv");
+    QStringList splitArgs = {
+        "-y", "-hide_banner", "-loglevel", "error",
+        "-i", job->inputPath(),
+        "-map", "0:v:0", "-c", "copy",
+        "-f", "segment",
+        "-segment_times", cutTimes.join(','),
+        "-segment_list", segmentList,
+        "-segment_list_type", "csv",
+        "-reset_timestamps", "1",
+        workDir.filePath("source_%03d.mkv")
+    };
+    if (!runFFmpeg(job, {splitArgs}, nullptr)) {
+        return false;
+    }
+    
+    // Each CSV row is "file,start,end"; sparse keyframes can yield fewer pieces than asked for
+    QStringList sources;
+    QVector<double> durations;
+    QFile listFile(segmentList);
+    if (listFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!listFile.atEnd()) {
+            QStringList fields = QString::fromUtf8(listFile.readLine()).trimmed().split(',');
+            if (fields.size() < 3) continue;
+            sources << workDir.filePath(fields[0]);
+            durations << qMax(0.0, fields[2].toDouble() - fields[1].toDouble());
+        }
+    }
+    if (sources.isEmpty()) {
+        m_lastError = "Splitting the video into chunks produced no segments";
+        Logger::error(m_lastError);
+        return false;
+    }
+    
+    reportProgress(15);
+    
+    QStringList encoded;
+    for (int i = 0; i < sources.size(); ++i) {
+        encoded << workDir.filePath(QString("encoded_%1.mkv").arg(i, 3, 10, QChar('0')));
+    }
+    
+    // Aggregate progress across pieces, weighted by their length
+    double totalChunkTime = 0;
+    for (double duration : durations) totalChunkTime += duration;
+    QVector<FFmpegProgress> latest(sources.size());
+    
+    // The job's CPU share is divided between the pieces of a wave instead of one wide
+    // encoder; each wave re-reads the grant, so threads the queue frees up mid-encode
+    // widen the next wave
+    for (int first = 0; first < sources.size(); ) {
+        int budget = qMax(1, job->threadBudget());
+        int parallel = qBound(1, budget / ThreadsPerChunk, static_cast<int>(sources.size()) - first);
+        int threadsPerChunk = qMax(1, budget / parallel);
+        
+        QList<QStringList> encodes;
+        for (int i = first; i < first + parallel; ++i) {
+            encodes << buildFFmpegArgs(job, sources[i], encoded[i], threadsPerChunk, false);
+        }
+        
+        bool ok = runFFmpeg(job, encodes, [&, first, parallel](int index, const FFmpegProgress& progress) {
+            latest[first + index] = progress;
+            
+            // Throughput of the pieces running now; progress over every piece so far
+            double done = 0;
+            double fps = 0;
+            double speed = 0;
+            for (int i = 0; i < latest.size(); ++i) {
+                done += qMin(latest[i].outTimeSeconds(), durations[i]);
+                if (i >= first && i < first + parallel) {
+                    fps += latest[i].fps;
+                    speed += latest[i].speed;
+                }
+            }
+            job->setEncodeRate(fps, speed);
+            
+            if (totalChunkTime > 0) {
+                reportProgress(qMin(90, static_cast<int>(15 + (done / totalChunkTime) * 75)));
+            }
+        });
+        if (!ok) {
+            return false;
+        }
+        first += parallel;
+    }
+    
+    reportProgress(90);
+    
+    // Concatenate the encoded pieces bit-exactly and mux the source audio back in
+    QString concatList = workDir.filePath("concat.txt");
+    QFile concatFile(concatList);
+    if (!concatFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_lastError = QString("Cannot write concat list: %1").arg(concatFile.errorString());
+        Logger::error(m_lastError);
+        return false;
+    }
+    for (const QString& piece : encoded) {
+        QString escaped = piece;
+        escaped.replace("'", "'\\''");
+        concatFile.write(QString("file '%1'\n").arg(escaped).toUtf8());
+    }
+    concatFile.close();
+    
+    QStringList concatArgs = {
+        "-y", "-hide_banner", "-loglevel", "error",
+        "-f", "concat", "-safe", "0", "-i", concatList,
+        "-i", job->inputPath(),
+        "-map", "0:v:0"
+    };
+    if (profile.preserveAudio) {
+        concatArgs << "-map" << "1:a:0?";
+    }
+    concatArgs << "-c:v" << "copy";
+    appendAudioArgs(concatArgs, profile);
+    concatArgs << "-map_metadata" << "1";
+    concatArgs << job->outputPath();
+    
+    if (!runFFmpeg(job, {concatArgs}, nullptr)) {
+        return false;
+    }
+    
+    return finishOutput(job);
+}
+
 void VideoProcessor::setProgressCallback(std::function<void(int)> callback)
 {
     m_progressCallback = callback;
@@ -160,167 +1164,308 @@ void VideoProcessor::setProgressCallback(std::function<void(int)> callback)
 
 bool VideoProcessor::checkFFmpeg()
 {
-    QProcess process;
-    process.start(m_ffmpegPath, {"-version"});
-    
-    if (!process.waitForFinished(5000)) {
-        m_lastError = "FFmpeg not found. Please install FFmpeg or set the path in settings.";
-        return false;
+    // The registry already ran "ffmpeg -version" for this binary
+    if (m_capabilities && m_capabilities->usable) {
+        return true;
     }
     
-    return process.exitCode() == 0;
+    m_lastError = "FFmpeg not found. Please install FFmpeg or set the path in settings.";
+    return false;
 }
 
-QStringList VideoProcessor::buildFFmpegArgs(Job* job)
+QStringList VideoProcessor::buildFFmpegArgs(Job* job, const QString& inputPath,
+                                            const QString& outputPath, int threadCount,
+                                            bool includeAudio)
 {
-    const auto& settings = Settings::instance();
+    const EncodeProfile& profile = job->profile();
     QStringList args;
 
     // Global options
     args << "-y";  // Overwrite output
     args << "-hide_banner";
     args << "-loglevel" << "info";
-    args << "-stats";
 
     // Determine output container from output path
     QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
-    QString codec = settings.videoCodec();
-    
-    // WebM only supports VP9 and AV1 - force compatible codec
-    bool isWebM = (outputExt == "webm");
     bool useNvencEncoder = false;
-    
-    if (isWebM) {
-        // WebM: must use VP9 or AV1 (software encoders, not NVENC)
-        if (codec != "vp9" && codec != "av1") {
-            codec = "vp9";  // Default to VP9 for WebM
-        }
-        // Don't use NVENC for WebM - use software encoder
-        useNvencEncoder = false;
-    } else {
-        // MP4/MKV: can use NVENC for H.264 and HEVC only
-        // AV1 NVENC has compatibility issues with CUDA hwaccel, use software encoder
-        useNvencEncoder = m_hasNvenc && (codec == "h264" || codec == "hevc");
-    }
+    QString codec = resolveCodec(profile, outputExt, useNvencEncoder);
 
     // Hardware decoding - only for NVENC encoders (not AV1)
     // Use hwaccel cuda but NOT hwaccel_output_format cuda to avoid format issues
-    if (m_hasNvdec && useNvencEncoder) {
+    if (m_hasNvdec && useNvencEncoder && !m_copyVideo) {
         args << "-hwaccel" << "cuda";
         // Don't use hwaccel_output_format cuda - let FFmpeg handle conversion
     }
 
+    // Thread budget granted by the job queue; shared by decoder and encoder
+    QString threads = QString::number(qMax(1, threadCount));
+
     // Input
-    args << "-i" << job->inputPath();
+    args << "-threads" << threads;
+    args << "-i" << inputPath;
 
     // Video encoding
-    if (codec == "copy") {
+    if (codec == "copy" || m_copyVideo) {
         args << "-c:v" << "copy";
+        
+        // Apple players only accept HEVC in MP4/MOV under the hvc1 tag
+        if (m_copyVideo && codec == "hevc" && (outputExt == "mp4" || outputExt == "mov" || outputExt == "m4v")) {
+            args << "-tag:v" << "hvc1";
+        }
     } else {
         // Select encoder based on codec and whether we can use NVENC
-        QString encoder;
-        if (codec == "hevc") {
-            encoder = useNvencEncoder ? "hevc_nvenc" : "libx265";
-        } else if (codec == "h264") {
-            encoder = useNvencEncoder ? "h264_nvenc" : "libx264";
-        } else if (codec == "vp9") {
-            encoder = "libvpx-vp9";
-        } else {
-            encoder = "libx264";  // Fallback
-        }
-        
+        QString encoder = encoderFor(codec, useNvencEncoder);
         args << "-c:v" << encoder;
 
         // CRF/Quality settings
-        QString compressionMode = settings.videoCompressionMode();
-        int crf = settings.videoCrf();
-        
-        if (compressionMode == "lossless") {
-            crf = 0;
-        } else if (compressionMode == "visually_lossless") {
-            crf = 18;
-        } else if (compressionMode == "high") {
-            crf = 23;
-        } else if (compressionMode == "medium") {
-            crf = 28;
-        } else if (compressionMode == "web") {
-            crf = 32;
-        }
+        int crf = m_crf;
 
         // Different encoders use different quality params
         if (useNvencEncoder) {
             args << "-cq" << QString::number(crf);
             args << "-preset" << "p4";  // NVENC preset
-        } else if (codec == "vp9") {
+        } else if (encoder == "libvpx-vp9") {
             args << "-crf" << QString::number(crf);
             args << "-b:v" << "0";  // Use CRF mode for VP9
+        } else if (encoder == "libsvtav1") {
+            args << "-crf" << QString::number(crf);
+            args << "-preset" << QString::number(svtAv1Preset(profile));
+        } else if (encoder == "libaom-av1") {
+            args << "-crf" << QString::number(crf);
+            args << "-b:v" << "0";
+            args << "-cpu-used" << QString::number(aomCpuUsed(profile));
+            if (profile.videoCompressionMode == "lossless") {
+                args << "-lossless" << "1";
+            }
         } else {
             args << "-crf" << QString::number(crf);
-            args << "-preset" << settings.videoPreset();
+            args << "-preset" << profile.videoPreset;
+        }
+        
+        // Tuning for the detected content; static screen captures drop repeated
+        // frames and keep the timestamps of the rest
+        for (const auto& option : contentOptions(encoder)) {
+            args << "-" + option.first << option.second;
+        }
+        if (m_contentClass == ContentClass::Screen) {
+            args << "-vf" << "mpdecimate" << vfrOption() << "vfr";
         }
 
         // Pixel format - only set when NOT using CUDA hw acceleration
         if (!useNvencEncoder) {
             args << "-pix_fmt" << "yuv420p";  // Standard 8-bit for compatibility
         }
+
+        // Cap software encoder threads; by default each one spawns a thread per core
+        if (!useNvencEncoder) {
+            args << "-threads" << threads;
+            if (encoder == "libx265") {
+                args << "-x265-params" << QString("pools=%1").arg(threads);
+            } else if (encoder == "libsvtav1") {
+                args << "-svtav1-params" << svtAv1Params(job, threadCount);
+            } else if (encoder == "libvpx-vp9" || encoder == "libaom-av1") {
+                args << "-row-mt" << "1";
+            }
+        }
     }
 
     // Audio encoding
-    if (settings.preserveAudio()) {
-        QString audioCodec = settings.audioCodec();
-        
-        if (audioCodec == "copy") {
-            args << "-c:a" << "copy";
-        } else if (audioCodec == "opus") {
-            args << "-c:a" << "libopus";
-            args << "-b:a" << QString("%1k").arg(settings.audioBitrate());
-        } else if (audioCodec == "aac") {
-            args << "-c:a" << "aac";
-            args << "-b:a" << QString("%1k").arg(settings.audioBitrate());
-        } else if (audioCodec == "flac") {
-            args << "-c:a" << "flac";
-        }
+    if (includeAudio) {
+        appendAudioArgs(args, profile);
     } else {
-        args << "-an";  // No audio
+        args << "-an";
     }
 
     // Output
-    args << job->outputPath();
+    args << outputPath;
 
     return args;
 }
 
-QString VideoProcessor::getVideoEncoder() const
+QString VideoProcessor::encoderFor(const QString& codec, bool useNvencEncoder) const
 {
-    const auto& settings = Settings::instance();
-    QString codec = settings.videoCodec();
+    QString encoder = "libx264";  // Fallback
+    if (codec == "hevc") {
+        encoder = useNvencEncoder ? "hevc_nvenc" : "libx265";
+    } else if (codec == "h264") {
+        encoder = useNvencEncoder ? "h264_nvenc" : "libx264";
+    } else if (codec == "vp9") {
+        encoder = "libvpx-vp9";
+    } else if (codec == "av1") {
+        encoder = "libsvtav1";
+    }
+    
+    if (hasEncoder(encoder)) {
+        return encoder;
+    }
+    
+    // libaom is far slower but still AV1; anything else would silently change the codec
+    if (codec == "av1" && hasEncoder("libaom-av1")) {
+        Logger::warning("libsvtav1 is not in this FFmpeg build, using libaom-av1");
+        return "libaom-av1";
+    }
+    
+    // Builds without libx265, libvpx or an AV1 encoder still get a working encode
+    Logger::warning(QString("%1 is not in this FFmpeg build, using libx264").arg(encoder));
+    return "libx264";
+}
 
-    if (codec == "av1") {
-        if (m_hasNvenc) {
-            return "av1_nvenc";
-        }
-        return "libsvtav1";  // SVT-AV1 is faster than libaom
-    } else if (codec == "hevc") {
-        if (m_hasNvenc) {
-            return "hevc_nvenc";
+int VideoProcessor::crfFor(Job* job) const
+{
+    const EncodeProfile& profile = job->profile();
+    QString compressionMode = profile.videoCompressionMode;
+    
+    // The scale belongs to the encoder that will actually run: AV1 may fall back to
+    // libaom or libx264
+    bool useNvencEncoder = false;
+    QString outputExt = QFileInfo(job->outputPath()).suffix().toLower();
+    QString encoder = encoderFor(resolveCodec(profile, outputExt, useNvencEncoder), useNvencEncoder);
+    
+    // AV1's 0-63 scale sits higher for the same quality; SVT-AV1 has no lossless mode,
+    // so "lossless" is its finest quantiser, while libaom encodes true lossless at 0
+    if (encoder == "libsvtav1" || encoder == "libaom-av1") {
+        if (compressionMode == "lossless") {
+            return encoder == "libaom-av1" ? 0 : 1;
+        } else if (compressionMode == "visually_lossless") {
+            return 23;
+        } else if (compressionMode == "high") {
+            return 30;
+        } else if (compressionMode == "medium") {
+            return 36;
+        } else if (compressionMode == "web") {
+            return 42;
         }
-        return "libx265";
-    } else if (codec == "h264") {
-        if (m_hasNvenc) {
-            return "h264_nvenc";
+        return profile.videoCrf;
+    }
+    
+    if (compressionMode == "lossless") {
+        return 0;
+    } else if (compressionMode == "visually_lossless") {
+        return 18;
+    } else if (compressionMode == "high") {
+        return 23;
+    } else if (compressionMode == "medium") {
+        return 28;
+    } else if (compressionMode == "web") {
+        return 32;
+    }
+    
+    return profile.videoCrf;
+}
+
+int VideoProcessor::svtAv1Preset(const EncodeProfile& profile)
+{
+    if (profile.av1Preset >= 0) {
+        return qMin(profile.av1Preset, 13);
+    }
+    
+    // Presets below 4 cost several times the encode time for a few percent of size
+    QString compressionMode = profile.videoCompressionMode;
+    if (compressionMode == "lossless" || compressionMode == "visually_lossless") {
+        return 4;
+    } else if (compressionMode == "medium") {
+        return 8;
+    } else if (compressionMode == "web") {
+        return 10;
+    }
+    return 6;
+}
+
+int VideoProcessor::aomCpuUsed(const EncodeProfile& profile)
+{
+    // libaom's speed scale is 0-8 against SVT-AV1's 0-13
+    return qBound(0, svtAv1Preset(profile) - 2, 8);
+}
+
+QString VideoProcessor::svtAv1Params(Job* job, int threadCount) const
+{
+    const EncodeProfile& profile = job->profile();
+    int processors = qMax(1, threadCount);
+    if (profile.av1MaxThreads > 0) {
+        processors = qMin(processors, profile.av1MaxThreads);
+    }
+    
+    QStringList params;
+    params << QString("lp=%1").arg(processors);
+    
+    // Tiles only pay off for a wide encoder on a large frame; with many narrow
+    // concurrent jobs they just cost compression
+    VideoInfo info = MediaInfo::getVideoInfo(job->inputPath(), job->profile().ffmpegPath);
+    int columns = profile.av1TileColumns;
+    if (columns < 0) {
+        columns = processors < 4 ? 0 : info.width >= 3840 ? 2 : info.width >= 1920 ? 1 : 0;
+    }
+    int rows = profile.av1TileRows;
+    if (rows < 0) {
+        rows = processors >= 8 && info.height >= 2160 ? 1 : 0;
+    }
+    if (columns > 0) params << QString("tile-columns=%1").arg(columns);
+    if (rows > 0) params << QString("tile-rows=%1").arg(rows);
+    
+    // The default lookahead holds over a hundred frames per encoder; several 4K
+    // encodes at once would otherwise exhaust memory before the CPUs
+    int lookahead = profile.av1Lookahead >= 0 ? profile.av1Lookahead : DefaultAv1Lookahead;
+    params << QString("lookahead=%1").arg(lookahead);
+    
+    // Screen content coding tools, or grain synthesis instead of spending bits on grain
+    if (m_contentClass == ContentClass::Screen) {
+        params << "scm=1";
+    } else if (m_contentClass == ContentClass::Grain) {
+        params << QString("film-grain=%1").arg(Av1FilmGrain);
+    }
+    
+    return params.join(':');
+}
+
+QString VideoProcessor::resolveCodec(const EncodeProfile& profile, const QString& outputExt,
+                                     bool& useNvencEncoder) const
+{
+    QString codec = profile.videoCodec;
+    
+    // WebM only supports VP9 and AV1 - force compatible codec
+    bool isWebM = (outputExt == "webm");
+    
+    if (isWebM) {
+        // WebM: must use VP9 or AV1 (software encoders, not NVENC)
+        if (codec != "vp9" && codec != "av1") {
+            codec = "vp9";  // Default to VP9 for WebM
         }
-        return "libx264";
-    } else if (codec == "vp9") {
-        return "libvpx-vp9";
+        // Don't use NVENC for WebM - use software encoder
+        useNvencEncoder = false;
+    } else {
+        // MP4/MKV: can use NVENC for H.264 and HEVC only
+        // AV1 NVENC has compatibility issues with CUDA hwaccel, use software encoder
+        useNvencEncoder = m_hasNvenc && (codec == "h264" || codec == "hevc") &&
+                          hasEncoder(codec + "_nvenc");
     }
+    
+    return codec;
+}
 
-    return "libx264";  // Fallback
+void VideoProcessor::appendAudioArgs(QStringList& args, const EncodeProfile& profile) const
+{
+    if (profile.preserveAudio) {
+        QString audioCodec = profile.audioCodec;
+        
+        if (audioCodec == "copy" || m_copyAudio) {
+            args << "-c:a" << "copy";
+        } else if (audioCodec == "opus") {
+            args << "-c:a" << "libopus";
+            args << "-b:a" << QString("%1k").arg(profile.audioBitrate);
+        } else if (audioCodec == "aac") {
+            args << "-c:a" << "aac";
+            args << "-b:a" << QString("%1k").arg(profile.audioBitrate);
+        } else if (audioCodec == "flac") {
+            args << "-c:a" << "flac";
+        }
+    } else {
+        args << "-an";  // No audio
+    }
 }
 
-QString VideoProcessor::getAudioEncoder() const
+QString VideoProcessor::getAudioEncoder(const EncodeProfile& profile) const
 {
-    const auto& settings = Settings::instance();
-    QString codec = settings.audioCodec();
+    QString codec = profile.audioCodec;
 
     if (codec == "opus") {
         return "libopus";
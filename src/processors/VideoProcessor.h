@@ -7,10 +7,17 @@
 #define VIDEOPROCESSOR_H
 
 #include <QString>
+#include <QStringList>
+#include <QPair>
 #include <QProcess>
 #include <functional>
+#include <memory>
+
+#include "FFmpegProgressParser.h"
 
 class Job;
+struct EncodeProfile;
+struct FFmpegCapabilities;
 
 class VideoProcessor
 {
@@ -20,15 +27,107 @@ public:
 
     bool process(Job* job);
     QString lastError() const { return m_lastError; }
+    
+    // True when the last job remuxed its video stream instead of encoding it
+    bool copiedVideo() const { return m_copyVideo; }
+    
+    // CRF and content class ("camera", "screen", ...) the last job was encoded with
+    int crf() const { return m_crf; }
+    QString contentClass() const { return contentClassName(m_contentClass); }
+    
+    // Dry run: encodes evenly spaced samples with the job's settings side by side and
+    // extrapolates the whole file's output size and encode time in core-seconds
+    bool estimateSamples(Job* job, qint64& outputSize, double& coreSeconds);
 
     void setProgressCallback(std::function<void(int)> callback);
 
 private:
+    void configure(const EncodeProfile& profile);
     bool checkFFmpeg();
-    QStringList buildFFmpegArgs(Job* job);
-    QString getVideoEncoder() const;
-    QString getAudioEncoder() const;
-    void parseFFmpegProgress(const QString& line, double totalDuration);
+    bool hasEncoder(const QString& name) const;
+    
+    // Single-file encode of inputPath into outputPath, using the job's profile and container
+    QStringList buildFFmpegArgs(Job* job, const QString& inputPath, const QString& outputPath,
+                                int threadCount, bool includeAudio);
+    QString encoderFor(const QString& codec, bool useNvencEncoder) const;
+    int crfFor(Job* job) const;
+    
+    // SVT-AV1 tuning from the profile's AV1 settings, or derived from the compression mode,
+    // resolution and thread grant when those are on auto
+    static int svtAv1Preset(const EncodeProfile& profile);
+    static int aomCpuUsed(const EncodeProfile& profile);
+    QString svtAv1Params(Job* job, int threadCount) const;
+    QString resolveCodec(const EncodeProfile& profile, const QString& outputExt,
+                         bool& useNvencEncoder) const;
+    void appendAudioArgs(QStringList& args, const EncodeProfile& profile) const;
+    
+    // Runs the ffmpeg invocations side by side; onProgress gets each one's -progress blocks.
+    // logTails, when given, receives the end of each invocation's log
+    bool runFFmpeg(Job* job, const QList<QStringList>& invocations,
+                   const std::function<void(int index, const FFmpegProgress& progress)>& onProgress,
+                   QStringList* logTails = nullptr);
+    
+    // Runs the invocations in waves of at most maxParallel; logTails stay in invocation order
+    bool runFFmpegBatched(Job* job, const QList<QStringList>& invocations, int maxParallel,
+                          QStringList* logTails = nullptr);
+    static int sampleParallelism(Job* job, int count);
+    
+    // Streams already in the target codec at no more bits per pixel than the compression
+    // mode would spend are remuxed; only the others are re-encoded
+    void planStreamCopy(Job* job);
+    static double maxBitsPerPixel(const QString& codec, const QString& compressionMode);
+    
+    // Target-quality mode: encode short samples at candidate CRFs in parallel, score them
+    // against lossless references and keep the largest CRF meeting the target in m_crf
+    bool searchTargetCrf(Job* job);
+    static bool parseQualityScore(const QString& metric, const QString& log, double& score);
+    
+    // Cache key of a search for this job's encoder, settings and content class; a hit
+    // sets m_crf without spawning anything
+    QString crfSearchSetup(Job* job) const;
+    bool cachedTargetCrf(Job* job);
+    
+    // What analyzeContent() found; each class gets its own encoder tuning
+    enum class ContentClass {
+        Camera,     // no special tuning
+        Grain,      // film grain or sensor noise worth preserving
+        Animation,  // flat areas, clean edges
+        Screen      // mostly static screen capture; duplicate frames are dropped
+    };
+    
+    // Per-frame averages over the analysed samples. Noise is the luma MSE against a
+    // spatially denoised copy; entropy is the normalised luma histogram entropy, which
+    // large flat areas pull down
+    struct ContentStats {
+        int frames = 0;
+        double duplicateFraction = 0;
+        double motion = 0;      // mean absolute luma change between frames, 0-255
+        double noise = 0;
+        double entropy = 0;
+    };
+    
+    // Sets m_contentClass from a quick statistics pass over a few short samples;
+    // leaves it at Camera when tuning is off, the video is copied or analysis fails
+    void planContentTuning(Job* job);
+    bool analyzeContent(Job* job, ContentStats& stats);
+    static ContentClass classifyContent(const ContentStats& stats);
+    static QString contentClassName(ContentClass contentClass);
+    
+    // Encoder AVOptions for m_contentClass, shared by the CLI and in-process paths
+    QList<QPair<QString, QString>> contentOptions(const QString& encoder) const;
+    QString vfrOption() const;
+    
+    // In-process path through LibavTranscoder; the CLI is the fallback
+    bool canEncodeInProcess(Job* job) const;
+    bool processInProcess(Job* job);
+    
+    // Chunked mode: split at keyframes, encode pieces in parallel waves sized from the
+    // job's current grant, concatenate losslessly
+    int chunkCountFor(Job* job, double totalDuration) const;
+    bool processChunked(Job* job, double totalDuration, int chunks);
+    bool finishOutput(Job* job);
+    
+    QString getAudioEncoder(const EncodeProfile& profile) const;
     void reportProgress(int progress);
 
 private:
@@ -37,6 +136,35 @@ private:
     QString m_ffmpegPath;
     bool m_hasNvenc = false;
     bool m_hasNvdec = false;
+    std::shared_ptr<const FFmpegCapabilities> m_capabilities;
+    double m_duration = 0;  // seconds, 0 while unknown
+    int m_crf = 18;         // quality for the current job, possibly found by searchTargetCrf()
+    bool m_copyVideo = false;   // set per job by planStreamCopy()
+    bool m_copyAudio = false;
+    ContentClass m_contentClass = ContentClass::Camera;  // set per job by planContentTuning()
+    
+    static constexpr double MinChunkSeconds = 30.0;
+    static constexpr int ThreadsPerChunk = 4;
+    static constexpr int MaxAutoChunks = 8;
+    static constexpr int SearchSamples = 3;
+    static constexpr double SampleSeconds = 4.0;
+    static constexpr int CandidatesPerRound = 4;
+    static constexpr int MaxSearchRounds = 3;
+    static constexpr int DefaultAv1Lookahead = 32;
+    static constexpr int EstimateSamples = 4;
+    static constexpr double EstimateSampleSeconds = 3.0;
+    static constexpr int AnalysisSamples = 4;
+    static constexpr double AnalysisSampleSeconds = 2.0;
+    static constexpr int AnalysisMaxWidth = 640;
+    
+    // Classification thresholds over ContentStats
+    static constexpr double DuplicateMotion = 0.25;
+    static constexpr double ScreenDuplicateFraction = 0.5;
+    static constexpr double ScreenMaxMotion = 2.0;
+    static constexpr double GrainNoise = 6.0;
+    static constexpr double CleanNoise = 2.0;
+    static constexpr double FlatEntropy = 0.75;
+    static constexpr int Av1FilmGrain = 8;
 };
 
 #endif // VIDEOPROCESSOR_H
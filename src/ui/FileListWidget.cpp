@@ -111,9 +111,7 @@ void FileListWidget::addFile(const QString& filePath)
     if (!info.exists()) return;
     
     // Check if file is already added
-    for (const auto& item : m_items) {
-        if (item.path == filePath) return;
-    }
+    if (m_pathIndex.contains(filePath)) return;
     
     FileItem fileItem;
     fileItem.id = generateJobId();
@@ -143,6 +141,8 @@ void FileListWidget::addFile(const QString& filePath)
     updateItemDisplay(treeItem, fileItem);
     
     m_treeWidget->addTopLevelItem(treeItem);
+    m_treeItems.insert(fileItem.id, treeItem);
+    m_pathIndex.insert(filePath, fileItem.id);
     
     emit filesAdded(1);
 }
@@ -161,7 +161,9 @@ void FileListWidget::removeSelected()
     
     for (auto* item : selected) {
         QString jobId = item->data(0, Qt::UserRole).toString();
+        m_pathIndex.remove(m_items.value(jobId).path);
         m_items.remove(jobId);
+        m_treeItems.remove(jobId);
         delete item;
     }
     
@@ -174,6 +176,9 @@ void FileListWidget::clear()
 {
     m_treeWidget->clear();
     m_items.clear();
+    m_treeItems.clear();
+    m_pathIndex.clear();
+    m_jobItems.clear();
     m_jobCounter = 0;
 }
 
@@ -208,58 +213,64 @@ QList<FileItem> FileListWidget::allItems() const
     return m_items.values();
 }
 
-void FileListWidget::updateProgress(const QString& jobId, int progress)
+void FileListWidget::updateProgress(JobId jobId, int progress)
 {
-    if (!m_items.contains(jobId)) return;
+    QString itemId = itemIdFor(jobId);
+    if (!m_items.contains(itemId)) return;
     
-    m_items[jobId].progress = progress;
-    m_items[jobId].status = static_cast<int>(Status::Processing);
+    m_items[itemId].progress = progress;
+    m_items[itemId].status = static_cast<int>(Status::Processing);
     
-    // Find and update tree item
-    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-        auto* item = m_treeWidget->topLevelItem(i);
-        if (item->data(0, Qt::UserRole).toString() == jobId) {
-            updateItemDisplay(item, m_items[jobId]);
-            break;
-        }
+    if (auto* item = treeItemFor(itemId)) {
+        updateItemDisplay(item, m_items[itemId]);
     }
 }
 
-void FileListWidget::setJobStatus(const QString& jobId, Status status)
+void FileListWidget::setJobStatus(JobId jobId, Status status)
 {
-    if (!m_items.contains(jobId)) return;
+    QString itemId = itemIdFor(jobId);
+    if (!m_items.contains(itemId)) return;
     
-    m_items[jobId].status = static_cast<int>(status);
+    m_items[itemId].status = static_cast<int>(status);
     if (status == Status::Completed) {
-        m_items[jobId].progress = 100;
+        m_items[itemId].progress = 100;
     }
     
-    // Find and update tree item
-    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-        auto* item = m_treeWidget->topLevelItem(i);
-        if (item->data(0, Qt::UserRole).toString() == jobId) {
-            updateItemDisplay(item, m_items[jobId]);
-            break;
-        }
+    if (auto* item = treeItemFor(itemId)) {
+        updateItemDisplay(item, m_items[itemId]);
     }
 }
 
-void FileListWidget::setOutputSize(const QString& jobId, qint64 size)
+void FileListWidget::setOutputSize(JobId jobId, qint64 size)
 {
-    if (!m_items.contains(jobId)) return;
+    QString itemId = itemIdFor(jobId);
+    if (!m_items.contains(itemId)) return;
     
-    m_items[jobId].outputSize = size;
+    m_items[itemId].outputSize = size;
     
-    // Find and update tree item
-    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-        auto* item = m_treeWidget->topLevelItem(i);
-        if (item->data(0, Qt::UserRole).toString() == jobId) {
-            updateItemDisplay(item, m_items[jobId]);
-            break;
-        }
+    if (auto* item = treeItemFor(itemId)) {
+        updateItemDisplay(item, m_items[itemId]);
+    }
+}
+
+void FileListWidget::bindJob(const QString& filePath, JobId jobId)
+{
+    auto it = m_pathIndex.constFind(filePath);
+    if (it != m_pathIndex.constEnd()) {
+        m_jobItems.insert(jobId, it.value());
     }
 }
 
+QString FileListWidget::itemIdFor(JobId jobId) const
+{
+    return m_jobItems.value(jobId);
+}
+
+QTreeWidgetItem* FileListWidget::treeItemFor(const QString& itemId) const
+{
+    return m_treeItems.value(itemId, nullptr);
+}
+
 void FileListWidget::contextMenuEvent(QContextMenuEvent *event)
 {
     auto* item = m_treeWidget->itemAt(m_treeWidget->mapFromParent(event->pos()));
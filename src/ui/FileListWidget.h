@@ -9,8 +9,11 @@
 #include <QWidget>
 #include <QTreeWidget>
 #include <QList>
+#include <QHash>
 #include <memory>
 
+#include "Job.h"
+
 struct FileItem {
     QString id;
     QString path;
@@ -50,9 +53,12 @@ public:
     QStringList allFiles() const;
     QList<FileItem> allItems() const;
     
-    void updateProgress(const QString& jobId, int progress);
-    void setJobStatus(const QString& jobId, Status status);
-    void setOutputSize(const QString& jobId, qint64 size);
+    void updateProgress(JobId jobId, int progress);
+    void setJobStatus(JobId jobId, Status status);
+    void setOutputSize(JobId jobId, qint64 size);
+    
+    // Routes JobQueue updates for jobId to the row holding filePath
+    void bindJob(const QString& filePath, JobId jobId);
 
 signals:
     void fileDoubleClicked(const QString& filePath);
@@ -72,9 +78,15 @@ private:
     QIcon getStatusIcon(Status status) const;
     QIcon getFileTypeIcon(const QString& type) const;
 
+    QString itemIdFor(JobId jobId) const;
+    QTreeWidgetItem* treeItemFor(const QString& itemId) const;
+
 private:
     QTreeWidget* m_treeWidget = nullptr;
     QMap<QString, FileItem> m_items;
+    QHash<QString, QTreeWidgetItem*> m_treeItems;
+    QHash<QString, QString> m_pathIndex;
+    QHash<JobId, QString> m_jobItems;
     int m_jobCounter = 0;
 };
 
@@ -13,6 +13,7 @@
 #include "Settings.h"
 #include "Logger.h"
 #include "FileUtils.h"
+#include "FormatUtils.h"
 
 #include <QMenuBar>
 #include <QToolBar>
@@ -21,6 +22,7 @@
 #include <QHBoxLayout>
 #include <QSplitter>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QCloseEvent>
 #include <QDragEnterEvent>
@@ -31,6 +33,8 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -45,6 +49,9 @@ MainWindow::MainWindow(QWidget *parent)
     setupShortcuts();
     loadSettings();
     
+    // Ask once the window is up whether to pick up an interrupted batch
+    QTimer::singleShot(0, this, &MainWindow::offerResume);
+    
     Logger::info("MainWindow initialized");
 }
 
@@ -114,6 +121,9 @@ void MainWindow::setupMenuBar()
         tr("Pause"), this, &MainWindow::onPauseConversion);
     processMenu->addAction(QIcon(":/icons/stop.svg"),
         tr("Stop"), this, &MainWindow::onStopConversion);
+    processMenu->addSeparator();
+    processMenu->addAction(tr("Estimate Size and Time (Dry Run)"),
+        this, &MainWindow::onEstimateBatch);
     
     auto* viewMenu = menuBar()->addMenu(tr("&View"));
     
@@ -291,6 +301,10 @@ void MainWindow::setupConnections()
     connect(m_btnSettings, &QToolButton::clicked, this, &MainWindow::onOpenSettings);
     connect(m_btnTheme, &QToolButton::clicked, this, &MainWindow::onToggleTheme);
     
+    m_estimateWatcher = new QFutureWatcher<QHash<QString, SampleEstimate>>(this);
+    connect(m_estimateWatcher, &QFutureWatcher<QHash<QString, SampleEstimate>>::finished,
+            this, &MainWindow::onEstimateFinished);
+    
     // Drop zone
     connect(m_dropZone, &DropZone::filesDropped, this, &MainWindow::addFilesToQueue);
     connect(m_dropZone, &DropZone::browseClicked, this, &MainWindow::onAddFiles);
@@ -306,12 +320,18 @@ void MainWindow::setupConnections()
     });
     
     // Job queue
-    connect(m_jobQueue.get(), &JobQueue::jobProgress, 
-            this, &MainWindow::onJobProgress);
+    connect(m_jobQueue.get(), &JobQueue::jobsAdded, 
+            this, &MainWindow::onJobsAdded);
+    connect(m_jobQueue.get(), &JobQueue::jobStarted, 
+            this, &MainWindow::onJobStarted);
+    connect(m_jobQueue.get(), &JobQueue::jobsProgressed, 
+            this, &MainWindow::onJobsProgressed);
     connect(m_jobQueue.get(), &JobQueue::jobCompleted, 
             this, &MainWindow::onJobCompleted);
     connect(m_jobQueue.get(), &JobQueue::jobFailed, 
             this, &MainWindow::onJobFailed);
+    connect(m_jobQueue.get(), &JobQueue::jobCancelled, 
+            this, &MainWindow::onJobCancelled);
     connect(m_jobQueue.get(), &JobQueue::allJobsCompleted, 
             this, &MainWindow::onAllJobsCompleted);
 }
@@ -392,6 +412,25 @@ void MainWindow::addFilesToQueue(const QStringList& files)
     m_statusLabel->setText(tr("%1 file(s) ready").arg(m_fileListWidget->fileCount()));
 }
 
+void MainWindow::offerResume()
+{
+    QStringList files = m_jobQueue->resumableFiles();
+    if (files.isEmpty()) return;
+    
+    auto result = QMessageBox::question(this, tr("Resume Batch"),
+        tr("A previous batch of %1 file(s) was interrupted. "
+           "Resume it? Files that already finished will be skipped.").arg(files.count()),
+        QMessageBox::Yes | QMessageBox::No);
+    
+    if (result == QMessageBox::No) {
+        m_jobQueue->discardResumableBatch();
+        return;
+    }
+    
+    addFilesToQueue(files);
+    onStartConversion();
+}
+
 void MainWindow::processDroppedItems(const QList<QUrl>& urls)
 {
     QStringList files;
@@ -430,6 +469,11 @@ void MainWindow::closeEvent(QCloseEvent *event)
         m_jobQueue->stopAll();
     }
     
+    if (m_estimateWatcher->isRunning()) {
+        SampleEstimator::instance().cancel();
+        m_estimateWatcher->waitForFinished();
+    }
+    
     saveSettings();
     event->accept();
 }
@@ -547,13 +591,18 @@ void MainWindow::onStartConversion()
     
     m_globalProgress->setValue(0);
     m_globalProgress->setVisible(true);
+    m_progressWidget->clear();
     m_progressWidget->setVisible(true);
     
-    // Create jobs and start processing
+    // Create jobs and start processing; a dry run's snapshot carries its estimates
+    // as long as the output folder was not picked afterwards
     auto files = m_fileListWidget->allFiles();
-    for (const auto& file : files) {
-        m_jobQueue->addJob(file, Settings::instance());
+    EncodeProfilePtr profile = m_estimateProfile;
+    if (!profile || profile->outputFolder != Settings::instance().outputFolder()) {
+        profile = EncodeProfile::fromSettings(Settings::instance());
     }
+    m_jobQueue->addJobs(files, profile);
+    m_etaTimer.invalidate();
     
     m_jobQueue->start();
     
@@ -602,11 +651,66 @@ void MainWindow::onStopConversion()
     }
 }
 
+void MainWindow::onEstimateBatch()
+{
+    if (m_isProcessing || m_estimateWatcher->isRunning()) return;
+    
+    if (m_fileListWidget->fileCount() == 0) {
+        QMessageBox::warning(this, tr("No Files"),
+            tr("Please add files to estimate."));
+        return;
+    }
+    
+    QStringList files = m_fileListWidget->allFiles();
+    m_estimateProfile = EncodeProfile::fromSettings(Settings::instance());
+    m_statusLabel->setText(tr("Estimating %1 file(s)...").arg(files.count()));
+    m_btnStart->setEnabled(false);
+    
+    EncodeProfilePtr profile = m_estimateProfile;
+    m_estimateWatcher->setFuture(QtConcurrent::run([this, files, profile]() {
+        return SampleEstimator::instance().estimateBatch(files, profile, [this](int done, int total) {
+            QMetaObject::invokeMethod(this, [this, done, total]() {
+                m_statusLabel->setText(tr("Estimating... %1 of %2 samples").arg(done).arg(total));
+            });
+        });
+    }));
+}
+
+void MainWindow::onEstimateFinished()
+{
+    m_btnStart->setEnabled(!m_isProcessing);
+    
+    const QHash<QString, SampleEstimate> estimates = m_estimateWatcher->result();
+    if (estimates.isEmpty()) {
+        m_estimateProfile.reset();
+        m_statusLabel->setText(tr("Estimate unavailable"));
+        return;
+    }
+    
+    qint64 outputSize = 0;
+    double coreSeconds = 0;
+    for (const SampleEstimate& estimate : estimates) {
+        outputSize += estimate.outputSize;
+        coreSeconds += estimate.coreSeconds;
+    }
+    
+    // Same spread over the machine as the queue's ETA
+    double wallSeconds = coreSeconds / qMax(1, Settings::instance().threadCount());
+    QString summary = tr("Estimate for %1 file(s): about %2 of output in %3")
+        .arg(estimates.size())
+        .arg(FileUtils::formatFileSize(outputSize))
+        .arg(FormatUtils::formatDuration(wallSeconds));
+    
+    m_statusLabel->setText(summary);
+    Logger::info(summary);
+}
+
 void MainWindow::onOpenSettings()
 {
     if (!m_settingsDialog) {
         m_settingsDialog = new SettingsDialog(this);
         connect(m_settingsDialog, &SettingsDialog::settingsChanged, [this]() {
+            m_estimateProfile.reset();
             updateStatusBar();
         });
     }
@@ -631,17 +735,50 @@ void MainWindow::onFileDoubleClicked(const QString& filePath)
     QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
 }
 
-void MainWindow::onJobProgress(const QString& jobId, int progress)
+void MainWindow::onJobsAdded(int first, int count)
+{
+    // One pass per batch ties queue job ids to the file list rows
+    for (Job* job : m_jobQueue->jobs(first, count)) {
+        m_fileListWidget->bindJob(job->inputPath(), job->id());
+        
+        if (job->status() == JobStatus::Completed) {
+            m_fileListWidget->setJobStatus(job->id(), FileListWidget::Status::Completed);
+        }
+    }
+}
+
+void MainWindow::onJobStarted(JobId jobId)
 {
-    m_fileListWidget->updateProgress(jobId, progress);
-    m_progressWidget->updateJob(jobId, progress);
+    // Only running jobs get a row; the file list already shows the whole batch
+    if (Job* job = m_jobQueue->getJob(jobId)) {
+        m_progressWidget->addJob(jobId, QFileInfo(job->inputPath()).fileName());
+    }
+}
+
+void MainWindow::onJobsProgressed(const QVector<JobProgressUpdate>& updates)
+{
+    for (const auto& update : updates) {
+        m_fileListWidget->updateProgress(update.jobId, update.progress);
+        m_progressWidget->updateJob(update.jobId, update.progress,
+                                    m_jobQueue->estimatedRemainingSeconds(update.jobId));
+    }
     
-    // Update global progress
+    // Update global progress once per batch
     int totalProgress = m_jobQueue->totalProgress();
     m_globalProgress->setValue(totalProgress);
+    
+    // The ETA walks every job, so it is refreshed at reading pace
+    if (!m_jobQueue->isPaused() && (!m_etaTimer.isValid() || m_etaTimer.elapsed() >= EtaRefreshMs)) {
+        m_etaTimer.start();
+        double remaining = m_jobQueue->estimatedRemainingSeconds();
+        if (remaining > 0) {
+            m_statusLabel->setText(tr("Processing... about %1 left")
+                .arg(FormatUtils::formatDuration(remaining)));
+        }
+    }
 }
 
-void MainWindow::onJobCompleted(const QString& jobId)
+void MainWindow::onJobCompleted(JobId jobId)
 {
     m_fileListWidget->setJobStatus(jobId, FileListWidget::Status::Completed);
     m_progressWidget->setJobCompleted(jobId);
@@ -649,12 +786,20 @@ void MainWindow::onJobCompleted(const QString& jobId)
     Logger::info(QString("Job completed: %1").arg(jobId));
 }
 
-void MainWindow::onJobFailed(const QString& jobId, const QString& error)
+void MainWindow::onJobFailed(JobId jobId, const QString& error)
 {
     m_fileListWidget->setJobStatus(jobId, FileListWidget::Status::Failed);
     m_progressWidget->setJobFailed(jobId, error);
     
-    Logger::error(QString("Job failed: %1 - %2").arg(jobId, error));
+    Logger::error(QString("Job failed: %1 - %2").arg(jobId).arg(error));
+}
+
+void MainWindow::onJobCancelled(JobId jobId)
+{
+    m_fileListWidget->setJobStatus(jobId, FileListWidget::Status::Failed);
+    m_progressWidget->setJobFailed(jobId, tr("Cancelled"));
+    
+    Logger::info(QString("Job cancelled: %1").arg(jobId));
 }
 
 void MainWindow::onAllJobsCompleted()
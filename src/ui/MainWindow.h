@@ -12,10 +12,13 @@
 #include <QLabel>
 #include <QToolButton>
 #include <QSystemTrayIcon>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 #include <memory>
 
 #include "GPUDetector.h"
 #include "JobQueue.h"
+#include "SampleEstimator.h"
 
 class FileListWidget;
 class DropZone;
@@ -46,12 +49,17 @@ private slots:
     void onStartConversion();
     void onPauseConversion();
     void onStopConversion();
+    void onEstimateBatch();
+    void onEstimateFinished();
     void onOpenSettings();
     void onToggleTheme();
     void onFileDoubleClicked(const QString& filePath);
-    void onJobProgress(const QString& jobId, int progress);
-    void onJobCompleted(const QString& jobId);
-    void onJobFailed(const QString& jobId, const QString& error);
+    void onJobsAdded(int first, int count);
+    void onJobStarted(JobId jobId);
+    void onJobsProgressed(const QVector<JobProgressUpdate>& updates);
+    void onJobCompleted(JobId jobId);
+    void onJobFailed(JobId jobId, const QString& error);
+    void onJobCancelled(JobId jobId);
     void onAllJobsCompleted();
     void onShowAbout();
     void onSelectOutputFolder();
@@ -68,6 +76,7 @@ private:
     void saveSettings();
     void updateStatusBar();
     void addFilesToQueue(const QStringList& files);
+    void offerResume();
     void processDroppedItems(const QList<QUrl>& urls);
 
 private:
@@ -104,9 +113,16 @@ private:
     std::unique_ptr<JobQueue> m_jobQueue;
     GPUInfo m_gpuInfo;
 
+    // Dry run; jobs queued with the estimated snapshot reuse its measurements
+    QFutureWatcher<QHash<QString, SampleEstimate>>* m_estimateWatcher = nullptr;
+    EncodeProfilePtr m_estimateProfile;
+    QElapsedTimer m_etaTimer;
+
     // State
     bool m_isProcessing = false;
     QString m_lastOutputFolder;
+    
+    static constexpr int EtaRefreshMs = 2000;
 };
 
 #endif // MAINWINDOW_H
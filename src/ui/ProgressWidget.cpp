@@ -4,11 +4,13 @@
  */
 
 #include "ProgressWidget.h"
+#include "FormatUtils.h"
 
 #include <QLabel>
 #include <QProgressBar>
 #include <QHBoxLayout>
 #include <QFrame>
+#include <QTimer>
 
 ProgressWidget::ProgressWidget(QWidget *parent)
     : QWidget(parent)
@@ -50,7 +52,7 @@ void ProgressWidget::setupUI()
     setMaximumHeight(300);
 }
 
-void ProgressWidget::addJob(const QString& jobId, const QString& fileName)
+void ProgressWidget::addJob(JobId jobId, const QString& fileName)
 {
     if (m_jobWidgets.contains(jobId)) return;
     
@@ -61,7 +63,7 @@ void ProgressWidget::addJob(const QString& jobId, const QString& fileName)
     m_jobsLayout->insertWidget(m_jobsLayout->count() - 1, jobWidget);
 }
 
-void ProgressWidget::updateJob(const QString& jobId, int progress)
+void ProgressWidget::updateJob(JobId jobId, int progress, double remainingSeconds)
 {
     if (!m_jobWidgets.contains(jobId)) return;
     
@@ -74,11 +76,16 @@ void ProgressWidget::updateJob(const QString& jobId, int progress)
     }
     
     if (statusLabel) {
-        statusLabel->setText(QString("%1%").arg(progress));
+        if (remainingSeconds > 0) {
+            statusLabel->setText(tr("%1% · %2 left").arg(progress)
+                .arg(FormatUtils::formatDuration(remainingSeconds)));
+        } else {
+            statusLabel->setText(QString("%1%").arg(progress));
+        }
     }
 }
 
-void ProgressWidget::setJobCompleted(const QString& jobId)
+void ProgressWidget::setJobCompleted(JobId jobId)
 {
     if (!m_jobWidgets.contains(jobId)) return;
     
@@ -106,9 +113,13 @@ void ProgressWidget::setJobCompleted(const QString& jobId)
         statusLabel->setText(tr("✓ Done"));
         statusLabel->setStyleSheet("color: #4CAF50; font-weight: 500;");
     }
+    
+    QTimer::singleShot(FinishedLingerMs, this, [this, jobId]() {
+        removeJob(jobId);
+    });
 }
 
-void ProgressWidget::setJobFailed(const QString& jobId, const QString& error)
+void ProgressWidget::setJobFailed(JobId jobId, const QString& error)
 {
     if (!m_jobWidgets.contains(jobId)) return;
     
@@ -138,6 +149,15 @@ void ProgressWidget::setJobFailed(const QString& jobId, const QString& error)
     }
 }
 
+void ProgressWidget::removeJob(JobId jobId)
+{
+    QWidget* widget = m_jobWidgets.take(jobId);
+    if (!widget) return;
+    
+    m_jobsLayout->removeWidget(widget);
+    delete widget;
+}
+
 void ProgressWidget::clear()
 {
     for (auto* widget : m_jobWidgets) {
@@ -147,7 +167,7 @@ void ProgressWidget::clear()
     m_jobWidgets.clear();
 }
 
-QWidget* ProgressWidget::createJobWidget(const QString& jobId, const QString& fileName)
+QWidget* ProgressWidget::createJobWidget(JobId jobId, const QString& fileName)
 {
     Q_UNUSED(jobId)
     
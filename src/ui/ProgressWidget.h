@@ -13,6 +13,8 @@
 #include <QLabel>
 #include <QProgressBar>
 
+#include "Job.h"
+
 class ProgressWidget : public QWidget
 {
     Q_OBJECT
@@ -21,20 +23,25 @@ public:
     explicit ProgressWidget(QWidget *parent = nullptr);
     ~ProgressWidget() = default;
 
-    void addJob(const QString& jobId, const QString& fileName);
-    void updateJob(const QString& jobId, int progress);
-    void setJobCompleted(const QString& jobId);
-    void setJobFailed(const QString& jobId, const QString& error);
+    void addJob(JobId jobId, const QString& fileName);
+    // remainingSeconds < 0 hides the per-job ETA
+    void updateJob(JobId jobId, int progress, double remainingSeconds = -1);
+    void setJobCompleted(JobId jobId);
+    void setJobFailed(JobId jobId, const QString& error);
+    void removeJob(JobId jobId);
     void clear();
 
 private:
     void setupUI();
-    QWidget* createJobWidget(const QString& jobId, const QString& fileName);
+    QWidget* createJobWidget(JobId jobId, const QString& fileName);
 
 private:
     QScrollArea* m_scrollArea = nullptr;
     QVBoxLayout* m_jobsLayout = nullptr;
-    QMap<QString, QWidget*> m_jobWidgets;
+    QMap<JobId, QWidget*> m_jobWidgets;
+    
+    // Finished rows stay briefly, then make room; failures stay until cleared
+    static constexpr int FinishedLingerMs = 1500;
 };
 
 #endif // PROGRESSWIDGET_H
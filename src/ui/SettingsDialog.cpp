@@ -5,7 +5,7 @@
 
 #include "SettingsDialog.h"
 #include "Settings.h"
-#include "GPUDetector.h"
+#include "CapabilityRegistry.h"
 #include "Logger.h"
 
 #include <QVBoxLayout>
@@ -103,10 +103,36 @@ void SettingsDialog::setupGeneralTab(QWidget* tab)
     processingLayout->addRow("", m_recursiveScanCheck);
     
     m_threadCountSpin = new QSpinBox;
-    m_threadCountSpin->setRange(1, 32);
+    m_threadCountSpin->setRange(1, 256);
     m_threadCountSpin->setSuffix(tr(" threads"));
     processingLayout->addRow(tr("Thread Count:"), m_threadCountSpin);
     
+    m_maxVideoJobsSpin = new QSpinBox;
+    m_maxVideoJobsSpin->setRange(1, 64);
+    m_maxVideoJobsSpin->setSuffix(tr(" jobs"));
+    m_maxVideoJobsSpin->setToolTip(tr("Concurrent FFmpeg encodes (each one is already multithreaded)"));
+    processingLayout->addRow(tr("Concurrent Videos:"), m_maxVideoJobsSpin);
+    
+    m_maxImageJobsSpin = new QSpinBox;
+    m_maxImageJobsSpin->setRange(1, 256);
+    m_maxImageJobsSpin->setSuffix(tr(" jobs"));
+    processingLayout->addRow(tr("Concurrent Images:"), m_maxImageJobsSpin);
+    
+    m_schedulingPolicyCombo = new QComboBox;
+    m_schedulingPolicyCombo->addItem(tr("In Order Added"), "fifo");
+    m_schedulingPolicyCombo->addItem(tr("Longest First (shortest total time)"), "longest_first");
+    m_schedulingPolicyCombo->addItem(tr("Shortest First (fastest feedback)"), "shortest_first");
+    processingLayout->addRow(tr("Job Order:"), m_schedulingPolicyCombo);
+    
+    m_expressSlotsSpin = new QSpinBox;
+    m_expressSlotsSpin->setRange(1, 16);
+    m_expressSlotsSpin->setSuffix(tr(" jobs"));
+    m_expressSlotsSpin->setToolTip(tr("Slots reserved for urgent jobs so they never wait behind a batch"));
+    processingLayout->addRow(tr("Express Slots:"), m_expressSlotsSpin);
+    
+    m_preemptForExpressCheck = new QCheckBox(tr("Suspend a batch encode while an urgent job runs"));
+    processingLayout->addRow("", m_preemptForExpressCheck);
+    
     layout->addWidget(processingGroup);
     
     // Appearance group
@@ -149,6 +175,9 @@ void SettingsDialog::setupGeneralTab(QWidget* tab)
     vipsLayout->addWidget(vipsBrowse);
     pathsLayout->addRow(tr("libvips:"), vipsLayout);
     
+    m_inProcessVideoCheck = new QCheckBox(tr("Encode videos in-process (falls back to FFmpeg executable)"));
+    pathsLayout->addRow("", m_inProcessVideoCheck);
+    
     layout->addWidget(pathsGroup);
     
     layout->addStretch();
@@ -238,6 +267,7 @@ void SettingsDialog::setupVideoTab(QWidget* tab)
     formatLayout->addRow(tr("Container:"), m_videoOutputFormatCombo);
     
     m_videoCodecCombo = new QComboBox;
+    m_videoCodecCombo->addItem("AV1 (SVT-AV1, smallest files)", "av1");
     m_videoCodecCombo->addItem("H.265/HEVC (Best compression)", "hevc");
     m_videoCodecCombo->addItem("H.264/AVC (Most compatible)", "h264");
     m_videoCodecCombo->addItem("VP9 (WebM)", "vp9");
@@ -257,6 +287,7 @@ void SettingsDialog::setupVideoTab(QWidget* tab)
     m_videoCompressionModeCombo->addItem(tr("Medium Quality (CRF 28)"), "medium");
     m_videoCompressionModeCombo->addItem(tr("Web Optimized (CRF 32)"), "web");
     m_videoCompressionModeCombo->addItem(tr("Custom CRF"), "custom");
+    m_videoCompressionModeCombo->addItem(tr("Target Quality (CRF search)"), "target_quality");
     qualityLayout->addRow(tr("Mode:"), m_videoCompressionModeCombo);
     
     m_videoCrfSpin = new QSpinBox;
@@ -265,6 +296,28 @@ void SettingsDialog::setupVideoTab(QWidget* tab)
     m_videoCrfSpin->setToolTip(tr("0 = lossless, 51+ = very lossy"));
     qualityLayout->addRow(tr("CRF Value:"), m_videoCrfSpin);
     
+    m_videoQualityMetricCombo = new QComboBox;
+    m_videoQualityMetricCombo->addItem(tr("VMAF (needs libvmaf)"), "vmaf");
+    m_videoQualityMetricCombo->addItem(tr("SSIM"), "ssim");
+    m_videoQualityMetricCombo->addItem(tr("PSNR (dB)"), "psnr");
+    qualityLayout->addRow(tr("Quality Metric:"), m_videoQualityMetricCombo);
+    
+    m_videoTargetQualitySpin = new QDoubleSpinBox;
+    m_videoTargetQualitySpin->setToolTip(tr("Short samples are encoded at several CRFs; the largest CRF meeting this score is used"));
+    qualityLayout->addRow(tr("Target Score:"), m_videoTargetQualitySpin);
+    
+    connect(m_videoQualityMetricCombo, &QComboBox::currentIndexChanged,
+            this, &SettingsDialog::updateTargetQualityRange);
+    updateTargetQualityRange();
+    
+    auto updateTargetControls = [this]() {
+        bool targeted = m_videoCompressionModeCombo->currentData().toString() == "target_quality";
+        m_videoQualityMetricCombo->setEnabled(targeted);
+        m_videoTargetQualitySpin->setEnabled(targeted);
+    };
+    connect(m_videoCompressionModeCombo, &QComboBox::currentIndexChanged, this, updateTargetControls);
+    updateTargetControls();
+    
     m_videoPresetCombo = new QComboBox;
     m_videoPresetCombo->addItem(tr("Ultrafast"), "ultrafast");
     m_videoPresetCombo->addItem(tr("Superfast"), "superfast");
@@ -278,8 +331,65 @@ void SettingsDialog::setupVideoTab(QWidget* tab)
     m_videoPresetCombo->setCurrentIndex(5); // Medium
     qualityLayout->addRow(tr("Preset:"), m_videoPresetCombo);
     
+    m_chunkedEncodeCheck = new QCheckBox(tr("Encode long videos in parallel chunks"));
+    m_chunkedEncodeCheck->setToolTip(tr("Splits at keyframes, encodes the pieces side by side and joins them losslessly"));
+    qualityLayout->addRow("", m_chunkedEncodeCheck);
+    
+    m_videoChunkCountSpin = new QSpinBox;
+    m_videoChunkCountSpin->setRange(0, 32);
+    m_videoChunkCountSpin->setSpecialValueText(tr("Auto"));
+    qualityLayout->addRow(tr("Chunks:"), m_videoChunkCountSpin);
+    
+    connect(m_chunkedEncodeCheck, &QCheckBox::toggled, m_videoChunkCountSpin, &QSpinBox::setEnabled);
+    
+    m_smartStreamCopyCheck = new QCheckBox(tr("Copy streams that already match the target"));
+    m_smartStreamCopyCheck->setToolTip(tr("Video and audio already in the target codec at a reasonable bitrate are remuxed instead of re-encoded"));
+    qualityLayout->addRow("", m_smartStreamCopyCheck);
+    
+    m_contentTuningCheck = new QCheckBox(tr("Tune for detected content"));
+    m_contentTuningCheck->setToolTip(tr("A short analysis detects screen recordings, animation and grainy footage; "
+                                        "duplicate frames of static screen captures are dropped"));
+    qualityLayout->addRow("", m_contentTuningCheck);
+    
     layout->addWidget(qualityGroup);
     
+    // AV1 group
+    auto* av1Group = new QGroupBox(tr("AV1 (SVT-AV1)"));
+    auto* av1Layout = new QFormLayout(av1Group);
+    
+    m_av1PresetSpin = new QSpinBox;
+    m_av1PresetSpin->setRange(-1, 13);
+    m_av1PresetSpin->setSpecialValueText(tr("Auto (from mode)"));
+    m_av1PresetSpin->setToolTip(tr("0 = slowest/best, 13 = fastest"));
+    av1Layout->addRow(tr("Preset:"), m_av1PresetSpin);
+    
+    m_av1TileColumnsSpin = new QSpinBox;
+    m_av1TileColumnsSpin->setRange(-1, 4);
+    m_av1TileColumnsSpin->setSpecialValueText(tr("Auto (from resolution)"));
+    m_av1TileColumnsSpin->setToolTip(tr("log2 of the number of tile columns"));
+    av1Layout->addRow(tr("Tile Columns:"), m_av1TileColumnsSpin);
+    
+    m_av1TileRowsSpin = new QSpinBox;
+    m_av1TileRowsSpin->setRange(-1, 4);
+    m_av1TileRowsSpin->setSpecialValueText(tr("Auto (from resolution)"));
+    m_av1TileRowsSpin->setToolTip(tr("log2 of the number of tile rows"));
+    av1Layout->addRow(tr("Tile Rows:"), m_av1TileRowsSpin);
+    
+    m_av1LookaheadSpin = new QSpinBox;
+    m_av1LookaheadSpin->setRange(-1, 120);
+    m_av1LookaheadSpin->setSpecialValueText(tr("Auto"));
+    m_av1LookaheadSpin->setSuffix(tr(" frames"));
+    m_av1LookaheadSpin->setToolTip(tr("Shorter lookahead uses less memory per encoder when many run at once"));
+    av1Layout->addRow(tr("Lookahead:"), m_av1LookaheadSpin);
+    
+    m_av1MaxThreadsSpin = new QSpinBox;
+    m_av1MaxThreadsSpin->setRange(0, 256);
+    m_av1MaxThreadsSpin->setSpecialValueText(tr("Job's share"));
+    m_av1MaxThreadsSpin->setToolTip(tr("Upper limit on logical processors per AV1 encoder"));
+    av1Layout->addRow(tr("Max Threads:"), m_av1MaxThreadsSpin);
+    
+    layout->addWidget(av1Group);
+    
     // Audio group
     auto* audioGroup = new QGroupBox(tr("Audio"));
     auto* audioLayout = new QFormLayout(audioGroup);
@@ -320,8 +430,7 @@ void SettingsDialog::setupGPUTab(QWidget* tab)
     m_gpuInfoLabel->setStyleSheet("QLabel { padding: 12px; background: #2d2d2d; border-radius: 8px; }");
     
     // Detect GPU
-    GPUDetector detector;
-    auto gpuInfo = detector.detect();
+    GPUInfo gpuInfo = CapabilityRegistry::instance().gpuInfo();
     
     if (gpuInfo.hasNvidia) {
         m_gpuInfoLabel->setText(QString(
@@ -399,6 +508,14 @@ void SettingsDialog::loadSettings()
     m_overwriteOriginalCheck->setChecked(settings.overwriteOriginal());
     m_recursiveScanCheck->setChecked(settings.recursiveScan());
     m_threadCountSpin->setValue(settings.threadCount());
+    m_maxVideoJobsSpin->setValue(settings.maxVideoJobs());
+    m_maxImageJobsSpin->setValue(settings.maxImageJobs());
+    
+    int policyIndex = m_schedulingPolicyCombo->findData(settings.schedulingPolicy());
+    if (policyIndex >= 0) m_schedulingPolicyCombo->setCurrentIndex(policyIndex);
+    
+    m_expressSlotsSpin->setValue(settings.expressSlots());
+    m_preemptForExpressCheck->setChecked(settings.preemptForExpress());
     
     int themeIndex = m_themeCombo->findData(settings.theme());
     if (themeIndex >= 0) m_themeCombo->setCurrentIndex(themeIndex);
@@ -432,9 +549,24 @@ void SettingsDialog::loadSettings()
     
     m_videoCrfSpin->setValue(settings.videoCrf());
     
+    int metricIndex = m_videoQualityMetricCombo->findData(settings.videoQualityMetric());
+    if (metricIndex >= 0) m_videoQualityMetricCombo->setCurrentIndex(metricIndex);
+    m_videoTargetQualitySpin->setValue(settings.videoTargetQuality());
+    
     int presetIndex = m_videoPresetCombo->findData(settings.videoPreset());
     if (presetIndex >= 0) m_videoPresetCombo->setCurrentIndex(presetIndex);
     
+    m_chunkedEncodeCheck->setChecked(settings.chunkedEncode());
+    m_videoChunkCountSpin->setValue(settings.videoChunkCount());
+    m_videoChunkCountSpin->setEnabled(settings.chunkedEncode());
+    m_smartStreamCopyCheck->setChecked(settings.smartStreamCopy());
+    m_contentTuningCheck->setChecked(settings.contentTuning());
+    m_av1PresetSpin->setValue(settings.av1Preset());
+    m_av1TileColumnsSpin->setValue(settings.av1TileColumns());
+    m_av1TileRowsSpin->setValue(settings.av1TileRows());
+    m_av1LookaheadSpin->setValue(settings.av1Lookahead());
+    m_av1MaxThreadsSpin->setValue(settings.av1MaxThreads());
+    
     m_preserveAudioCheck->setChecked(settings.preserveAudio());
     
     int audioCodecIndex = m_audioCodecCombo->findData(settings.audioCodec());
@@ -455,6 +587,7 @@ void SettingsDialog::loadSettings()
     // Paths
     m_ffmpegPathEdit->setText(settings.ffmpegPath());
     m_vipsPathEdit->setText(settings.vipsPath());
+    m_inProcessVideoCheck->setChecked(settings.inProcessVideo());
 }
 
 void SettingsDialog::saveSettings()
@@ -466,6 +599,11 @@ void SettingsDialog::saveSettings()
     settings.setOverwriteOriginal(m_overwriteOriginalCheck->isChecked());
     settings.setRecursiveScan(m_recursiveScanCheck->isChecked());
     settings.setThreadCount(m_threadCountSpin->value());
+    settings.setMaxVideoJobs(m_maxVideoJobsSpin->value());
+    settings.setMaxImageJobs(m_maxImageJobsSpin->value());
+    settings.setSchedulingPolicy(m_schedulingPolicyCombo->currentData().toString());
+    settings.setExpressSlots(m_expressSlotsSpin->value());
+    settings.setPreemptForExpress(m_preemptForExpressCheck->isChecked());
     settings.setTheme(m_themeCombo->currentData().toString());
     settings.setShowNotifications(m_showNotificationsCheck->isChecked());
     settings.setPlaySounds(m_playSoundsCheck->isChecked());
@@ -485,7 +623,18 @@ void SettingsDialog::saveSettings()
     settings.setVideoCodec(m_videoCodecCombo->currentData().toString());
     settings.setVideoCompressionMode(m_videoCompressionModeCombo->currentData().toString());
     settings.setVideoCrf(m_videoCrfSpin->value());
+    settings.setVideoQualityMetric(m_videoQualityMetricCombo->currentData().toString());
+    settings.setVideoTargetQuality(m_videoTargetQualitySpin->value());
     settings.setVideoPreset(m_videoPresetCombo->currentData().toString());
+    settings.setChunkedEncode(m_chunkedEncodeCheck->isChecked());
+    settings.setVideoChunkCount(m_videoChunkCountSpin->value());
+    settings.setSmartStreamCopy(m_smartStreamCopyCheck->isChecked());
+    settings.setContentTuning(m_contentTuningCheck->isChecked());
+    settings.setAv1Preset(m_av1PresetSpin->value());
+    settings.setAv1TileColumns(m_av1TileColumnsSpin->value());
+    settings.setAv1TileRows(m_av1TileRowsSpin->value());
+    settings.setAv1Lookahead(m_av1LookaheadSpin->value());
+    settings.setAv1MaxThreads(m_av1MaxThreadsSpin->value());
     settings.setPreserveAudio(m_preserveAudioCheck->isChecked());
     settings.setAudioCodec(m_audioCodecCombo->currentData().toString());
     settings.setAudioBitrate(m_audioBitrateSpin->value());
@@ -500,6 +649,7 @@ void SettingsDialog::saveSettings()
     // Paths
     settings.setFfmpegPath(m_ffmpegPathEdit->text());
     settings.setVipsPath(m_vipsPathEdit->text());
+    settings.setInProcessVideo(m_inProcessVideoCheck->isChecked());
     
     settings.save();
 }
@@ -517,6 +667,25 @@ void SettingsDialog::onReset()
     loadSettings();
 }
 
+void SettingsDialog::updateTargetQualityRange()
+{
+    // Each metric has its own scale
+    QString metric = m_videoQualityMetricCombo->currentData().toString();
+    if (metric == "ssim") {
+        m_videoTargetQualitySpin->setRange(0.5, 1.0);
+        m_videoTargetQualitySpin->setDecimals(3);
+        m_videoTargetQualitySpin->setSingleStep(0.001);
+    } else if (metric == "psnr") {
+        m_videoTargetQualitySpin->setRange(20.0, 60.0);
+        m_videoTargetQualitySpin->setDecimals(1);
+        m_videoTargetQualitySpin->setSingleStep(0.5);
+    } else {
+        m_videoTargetQualitySpin->setRange(50.0, 100.0);
+        m_videoTargetQualitySpin->setDecimals(1);
+        m_videoTargetQualitySpin->setSingleStep(0.5);
+    }
+}
+
 void SettingsDialog::onBrowseOutputFolder()
 {
     QString folder = QFileDialog::getExistingDirectory(
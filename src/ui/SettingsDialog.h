@@ -11,6 +11,7 @@
 #include <QComboBox>
 #include <QCheckBox>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QSlider>
@@ -33,6 +34,7 @@ private slots:
     void onBrowseOutputFolder();
     void onBrowseFFmpegPath();
     void onBrowseVipsPath();
+    void updateTargetQualityRange();
 
 private:
     void setupUI();
@@ -51,6 +53,11 @@ private:
     QCheckBox* m_overwriteOriginalCheck = nullptr;
     QCheckBox* m_recursiveScanCheck = nullptr;
     QSpinBox* m_threadCountSpin = nullptr;
+    QSpinBox* m_maxVideoJobsSpin = nullptr;
+    QSpinBox* m_maxImageJobsSpin = nullptr;
+    QComboBox* m_schedulingPolicyCombo = nullptr;
+    QSpinBox* m_expressSlotsSpin = nullptr;
+    QCheckBox* m_preemptForExpressCheck = nullptr;
     QComboBox* m_themeCombo = nullptr;
     QCheckBox* m_showNotificationsCheck = nullptr;
     QCheckBox* m_playSoundsCheck = nullptr;
@@ -70,7 +77,18 @@ private:
     QComboBox* m_videoCodecCombo = nullptr;
     QComboBox* m_videoCompressionModeCombo = nullptr;
     QSpinBox* m_videoCrfSpin = nullptr;
+    QComboBox* m_videoQualityMetricCombo = nullptr;
+    QDoubleSpinBox* m_videoTargetQualitySpin = nullptr;
     QComboBox* m_videoPresetCombo = nullptr;
+    QCheckBox* m_chunkedEncodeCheck = nullptr;
+    QSpinBox* m_videoChunkCountSpin = nullptr;
+    QCheckBox* m_smartStreamCopyCheck = nullptr;
+    QCheckBox* m_contentTuningCheck = nullptr;
+    QSpinBox* m_av1PresetSpin = nullptr;
+    QSpinBox* m_av1TileColumnsSpin = nullptr;
+    QSpinBox* m_av1TileRowsSpin = nullptr;
+    QSpinBox* m_av1LookaheadSpin = nullptr;
+    QSpinBox* m_av1MaxThreadsSpin = nullptr;
     QCheckBox* m_preserveAudioCheck = nullptr;
     QComboBox* m_audioCodecCombo = nullptr;
     QSpinBox* m_audioBitrateSpin = nullptr;
@@ -86,6 +104,7 @@ private:
     // Paths
     QLineEdit* m_ffmpegPathEdit = nullptr;
     QLineEdit* m_vipsPathEdit = nullptr;
+    QCheckBox* m_inProcessVideoCheck = nullptr;
 
     QPushButton* m_applyButton = nullptr;
     QPushButton* m_resetButton = nullptr;
@@ -6,9 +6,26 @@
 #include "FileUtils.h"
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QDirIterator>
 
+// Header-only: inlines XXH3 here instead of linking a separate xxhash.c
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 QStringList FileUtils::supportedImageExtensions()
 {
     return {"png", "jpg", "jpeg", "webp", "avif", "heic", "heif", 
@@ -127,3 +144,80 @@ bool FileUtils::ensureDirectoryExists(const QString& path)
     
     return dir.mkpath(".");
 }
+
+QString FileUtils::fileChecksum(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    
+    // Checksums only identify content (dedup, resume), nobody forges them, so
+    // XXH3-128 is enough and runs near memory bandwidth, unlike a cryptographic hash
+    XXH3_state_t state;
+    XXH3_128bits_reset(&state);
+    
+    QByteArray buffer(1 << 20, Qt::Uninitialized);
+    qint64 bytesRead = 0;
+    while ((bytesRead = file.read(buffer.data(), buffer.size())) > 0) {
+        XXH3_128bits_update(&state, buffer.constData(), static_cast<size_t>(bytesRead));
+    }
+    if (bytesRead < 0) {
+        return QString();
+    }
+    
+    XXH128_canonical_t canonical;
+    XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(&state));
+    QByteArray digest(reinterpret_cast<const char*>(canonical.digest), sizeof(canonical.digest));
+    return QString::fromLatin1(digest.toHex());
+}
+
+bool FileUtils::linkOrCopy(const QString& source, const QString& target)
+{
+    if (QFileInfo(source).absoluteFilePath() == QFileInfo(target).absoluteFilePath()) {
+        return true;
+    }
+    
+    ensureDirectoryExists(QFileInfo(target).absolutePath());
+    if (QFile::exists(target)) {
+        QFile::remove(target);
+    }
+    
+    QByteArray sourcePath = QFile::encodeName(source);
+    QByteArray targetPath = QFile::encodeName(target);
+    
+#ifdef Q_OS_LINUX
+    // Copy-on-write clone: shares extents like a hardlink but stays an independent file
+    int sourceFd = ::open(sourcePath.constData(), O_RDONLY);
+    if (sourceFd >= 0) {
+        int targetFd = ::open(targetPath.constData(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (targetFd >= 0) {
+            bool cloned = ::ioctl(targetFd, FICLONE, sourceFd) == 0;
+            ::close(targetFd);
+            if (cloned) {
+                ::close(sourceFd);
+                return true;
+            }
+            QFile::remove(target);
+        }
+        ::close(sourceFd);
+    }
+#endif
+    
+#ifdef Q_OS_WIN
+    Q_UNUSED(sourcePath)
+    Q_UNUSED(targetPath)
+    if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(target).utf16()),
+                        reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(source).utf16()),
+                        nullptr)) {
+        return true;
+    }
+#else
+    if (::link(sourcePath.constData(), targetPath.constData()) == 0) {
+        return true;
+    }
+#endif
+    
+    // Different volumes or no link support
+    return QFile::copy(source, target);
+}
@@ -19,6 +19,10 @@ public:
     static QString formatFileSize(qint64 bytes);
     static QString getUniqueFileName(const QString& path);
     static bool ensureDirectoryExists(const QString& path);
+    static QString fileChecksum(const QString& path);
+    
+    // Reflink, then hardlink, then plain copy; replaces an existing target
+    static bool linkOrCopy(const QString& source, const QString& target);
     
     static QStringList supportedImageExtensions();
     static QStringList supportedVideoExtensions();
@@ -89,6 +89,26 @@ bool FormatUtils::isLosslessFormat(const QString& format)
     return false;
 }
 
+QString FormatUtils::formatDuration(double seconds)
+{
+    qint64 total = qMax<qint64>(0, qRound64(seconds));
+    if (total < 60) {
+        return QString("%1 s").arg(total);
+    }
+    
+    qint64 minutes = total / 60;
+    if (minutes < 60) {
+        return QString("%1 min").arg(minutes);
+    }
+    
+    qint64 hours = minutes / 60;
+    if (hours < 48) {
+        return QString("%1 h %2 min").arg(hours).arg(minutes % 60);
+    }
+    
+    return QString("%1 d %2 h").arg(hours / 24).arg(hours % 24);
+}
+
 QString FormatUtils::getFormatDescription(const QString& format)
 {
     QString lower = format.toLower();
@@ -21,6 +21,9 @@ public:
     static QString getMimeType(const QString& format);
     static bool isLosslessFormat(const QString& format);
     static QString getFormatDescription(const QString& format);
+    
+    // Coarse human duration for estimates, e.g. "45 s", "12 min", "3 h 20 min"
+    static QString formatDuration(double seconds);
 };
 
 #endif // FORMATUTILS_H
@@ -0,0 +1,51 @@
+/**
+ * @file OutputRing.cpp
+ * @brief Output ring buffer implementation
+ */
+
+#include "OutputRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+OutputRing::OutputRing(int capacity)
+    : m_buffer(static_cast<size_t>(qMax(1, capacity)))
+{
+}
+
+void OutputRing::append(const char* data, qint64 size)
+{
+    if (size <= 0) return;
+    m_total += size;
+    
+    // Only the last capacity() bytes of a large write can survive
+    const int cap = capacity();
+    if (size > cap) {
+        data += size - cap;
+        size = cap;
+    }
+    
+    int first = static_cast<int>(std::min<qint64>(size, cap - m_head));
+    std::memcpy(m_buffer.data() + m_head, data, first);
+    std::memcpy(m_buffer.data(), data + first, size - first);
+    m_head = static_cast<int>((m_head + size) % cap);
+}
+
+void OutputRing::clear()
+{
+    m_head = 0;
+    m_total = 0;
+}
+
+QByteArray OutputRing::contents() const
+{
+    if (!wrapped()) {
+        return QByteArray(m_buffer.data(), static_cast<int>(m_total));
+    }
+    
+    QByteArray result;
+    result.reserve(capacity());
+    result.append(m_buffer.data() + m_head, capacity() - m_head);
+    result.append(m_buffer.data(), m_head);
+    return result;
+}
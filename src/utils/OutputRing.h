@@ -0,0 +1,40 @@
+/**
+ * @file OutputRing.h
+ * @brief Fixed-size ring buffer for child process output
+ */
+
+#ifndef OUTPUTRING_H
+#define OUTPUTRING_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+// Keeps only the most recent bytes of a tool's output, so memory per job
+// stays constant however long the tool runs; the tail is what diagnostics need
+class OutputRing
+{
+public:
+    explicit OutputRing(int capacity = DefaultCapacity);
+
+    void append(const char* data, qint64 size);
+    void append(const QByteArray& data) { append(data.constData(), data.size()); }
+    void clear();
+
+    // Retained bytes in arrival order
+    QByteArray contents() const;
+    QString text() const { return QString::fromUtf8(contents()); }
+    
+    int capacity() const { return static_cast<int>(m_buffer.size()); }
+    qint64 totalBytes() const { return m_total; }
+    bool wrapped() const { return m_total > capacity(); }
+
+    static constexpr int DefaultCapacity = 16 * 1024;
+
+private:
+    std::vector<char> m_buffer;
+    int m_head = 0;         // next write position
+    qint64 m_total = 0;     // bytes ever appended
+};
+
+#endif // OUTPUTRING_H
@@ -0,0 +1,176 @@
+/**
+ * @file ProcessUtils.cpp
+ * @brief Child process helpers implementation
+ */
+
+#include "ProcessUtils.h"
+#include "Logger.h"
+#include "OutputRing.h"
+
+#include <QElapsedTimer>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_WIN
+typedef LONG (NTAPI *NtProcessControlFn)(HANDLE);
+
+// Undocumented but stable ntdll entry points; suspend every thread of a process at once
+static bool controlProcess(qint64 pid, const char* entryPoint)
+{
+    static HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+    if (!ntdll) return false;
+    
+    auto control = reinterpret_cast<NtProcessControlFn>(GetProcAddress(ntdll, entryPoint));
+    if (!control) return false;
+    
+    HANDLE handle = OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, static_cast<DWORD>(pid));
+    if (!handle) return false;
+    
+    LONG status = control(handle);
+    CloseHandle(handle);
+    return status >= 0;
+}
+#endif
+
+void ProcessUtils::prepare(QProcess& process)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(process)
+#else
+    // A group of its own lets suspend() reach helpers the encoder spawns
+    process.setChildProcessModifier([]() {
+        ::setpgid(0, 0);
+    });
+#endif
+}
+
+ProcessWaitResult ProcessUtils::waitForFinished(QProcess& process,
+                                                const std::function<bool()>& isCancelled,
+                                                const std::function<bool()>& isPaused,
+                                                int timeoutMs,
+                                                OutputRing* stdOut,
+                                                OutputRing* stdErr)
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    bool suspended = false;
+    qint64 suspendedMs = 0;
+    QElapsedTimer suspendedTimer;
+    
+    while (process.state() != QProcess::NotRunning) {
+        if (isCancelled && isCancelled()) {
+            kill(process);
+            return ProcessWaitResult::Cancelled;
+        }
+        
+        if (isPaused) {
+            bool wasSuspended = suspended;
+            syncSuspended(process, isPaused(), suspended);
+            if (suspended && !wasSuspended) {
+                suspendedTimer.start();
+            } else if (!suspended && wasSuspended) {
+                suspendedMs += suspendedTimer.elapsed();
+            }
+        }
+        
+        qint64 activeMs = timer.elapsed() - suspendedMs -
+            (suspended ? suspendedTimer.elapsed() : 0);
+        if (timeoutMs >= 0 && activeMs >= timeoutMs) {
+            kill(process);
+            return ProcessWaitResult::TimedOut;
+        }
+        
+        process.waitForFinished(PollIntervalMs);
+        
+        if (stdOut) drain(process, QProcess::StandardOutput, *stdOut);
+        if (stdErr) drain(process, QProcess::StandardError, *stdErr);
+    }
+    
+    if (stdOut) drain(process, QProcess::StandardOutput, *stdOut);
+    if (stdErr) drain(process, QProcess::StandardError, *stdErr);
+    
+    return ProcessWaitResult::Finished;
+}
+
+void ProcessUtils::drain(QProcess& process, QProcess::ProcessChannel channel, OutputRing& ring)
+{
+    QProcess::ProcessChannel previous = process.readChannel();
+    process.setReadChannel(channel);
+    
+    char buffer[4096];
+    qint64 n;
+    while ((n = process.read(buffer, sizeof(buffer))) > 0) {
+        ring.append(buffer, n);
+    }
+    
+    process.setReadChannel(previous);
+}
+
+void ProcessUtils::kill(QProcess& process)
+{
+    if (process.state() == QProcess::NotRunning) return;
+    
+    // Encoders hold no state worth a graceful shutdown once the output is discarded;
+    // SIGKILL and TerminateProcess both work on suspended processes too
+#ifndef Q_OS_WIN
+    qint64 pid = process.processId();
+    if (pid > 0) {
+        ::kill(-static_cast<pid_t>(pid), SIGKILL);
+    }
+#endif
+    process.kill();
+    process.waitForFinished(1000);
+}
+
+bool ProcessUtils::suspend(QProcess& process)
+{
+    qint64 pid = process.processId();
+    if (pid <= 0) return false;
+    
+#ifdef Q_OS_WIN
+    bool ok = controlProcess(pid, "NtSuspendProcess");
+#else
+    bool ok = ::kill(-static_cast<pid_t>(pid), SIGSTOP) == 0 ||
+              ::kill(static_cast<pid_t>(pid), SIGSTOP) == 0;
+#endif
+    
+    if (!ok) {
+        Logger::warning(QString("Failed to suspend process %1").arg(pid));
+    }
+    return ok;
+}
+
+bool ProcessUtils::resume(QProcess& process)
+{
+    qint64 pid = process.processId();
+    if (pid <= 0) return false;
+    
+#ifdef Q_OS_WIN
+    bool ok = controlProcess(pid, "NtResumeProcess");
+#else
+    bool ok = ::kill(-static_cast<pid_t>(pid), SIGCONT) == 0 ||
+              ::kill(static_cast<pid_t>(pid), SIGCONT) == 0;
+#endif
+    
+    if (!ok) {
+        Logger::warning(QString("Failed to resume process %1").arg(pid));
+    }
+    return ok;
+}
+
+void ProcessUtils::syncSuspended(QProcess& process, bool requested, bool& suspended)
+{
+    if (requested == suspended) return;
+    
+    if (requested) {
+        suspended = suspend(process);
+    } else {
+        suspended = !resume(process);
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * @file ProcessUtils.h
+ * @brief Child process helpers header
+ */
+
+#ifndef PROCESSUTILS_H
+#define PROCESSUTILS_H
+
+#include <QProcess>
+#include <functional>
+
+class OutputRing;
+
+enum class ProcessWaitResult {
+    Finished,
+    Cancelled,
+    TimedOut
+};
+
+class ProcessUtils
+{
+public:
+    // Call before start(); puts the child in its own process group on Unix
+    static void prepare(QProcess& process);
+    
+    // Polls in short slices so a cancel request kills the child within milliseconds
+    // and a pause request suspends it; time spent suspended does not count as timeout
+    static ProcessWaitResult waitForFinished(QProcess& process,
+                                             const std::function<bool()>& isCancelled,
+                                             const std::function<bool()>& isPaused = nullptr,
+                                             int timeoutMs = -1,
+                                             OutputRing* stdOut = nullptr,
+                                             OutputRing* stdErr = nullptr);
+    
+    // Moves whatever the channel has buffered into the ring so QProcess never
+    // accumulates a long-running tool's output; restores the current read channel
+    static void drain(QProcess& process, QProcess::ProcessChannel channel, OutputRing& ring);
+    
+    static void kill(QProcess& process);
+    
+    // SIGSTOP/SIGCONT to the process group on Unix, NtSuspendProcess on Windows
+    static bool suspend(QProcess& process);
+    static bool resume(QProcess& process);
+    
+    // Suspends or resumes the child when the requested state differs from `suspended`
+    static void syncSuspended(QProcess& process, bool requested, bool& suspended);
+    
+    static constexpr int PollIntervalMs = 50;
+};
+
+#endif // PROCESSUTILS_H